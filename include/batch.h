@@ -0,0 +1,62 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "thread_pool.h"
+#include "tictactoe.h"
+
+struct BatchPosition {
+    int boardSizeX = 3;
+    int boardSizeY = 3;
+    int matchLength = 3;
+    std::vector<std::pair<int, int>> moves;  // played from the empty board, X first
+};
+
+struct BatchOptions {
+    int threads = 0;  // 0 uses every hardware thread
+    int maxDepth = 6;
+    int moveTimeMs = 0;  // per position, 0 for no time limit
+    unsigned long long maxNodes = 0;  // per position, 0 for no node limit
+    size_t hashSizeMB = 16;  // per cached engine
+};
+
+struct BatchResult {
+    size_t index = 0;  // position's index in the submitted batch
+    bool valid = false;  // false if the board or the move list was illegal, or the game is over
+    std::string error;  // why the position was not analyzed, empty when valid
+    std::pair<int, int> bestMove = { -1, -1 };
+    double milliseconds = 0;
+    SearchStats stats;  // of the search that produced bestMove
+};
+
+// Analyzes many positions on a work-stealing pool.
+// Every worker keeps one engine per (width, height, matchLength) and reuses it for
+// later positions of that size, transposition table included, so a batch costs no
+// per-position allocation beyond the first of each size.
+class BatchAnalyzer {
+public:
+    using ResultCallback = std::function<void(const BatchResult&)>;
+
+private:
+    using EngineKey = std::tuple<int, int, int>;
+
+    BatchOptions options;
+    WorkStealingPool pool;
+    std::vector<std::map<EngineKey, std::unique_ptr<TicTacToe>>> engines;  // per worker
+    std::mutex resultMutex;
+
+    BatchResult analyzePosition(int worker, size_t index, const BatchPosition& position);
+
+public:
+    explicit BatchAnalyzer(const BatchOptions& options = BatchOptions());
+
+    // Blocks until the whole batch is done. Results are streamed to onResult as they
+    // complete, in completion order, one call at a time.
+    void analyze(const std::vector<BatchPosition>& positions, const ResultCallback& onResult);
+};
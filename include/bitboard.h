@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+
+#include "line_kernels.h"
+
+// One bit per cell for a single player's stones.
+// Cells are stored row-major with a stride of (width + 1): the extra column is always
+// empty, so stepping right or diagonally from the last column lands on a zero bit
+// instead of wrapping into the next row. Zeroed guard words before and after the
+// board let line scans read shifted words without any bounds checks; the trailing
+// guard is a few words wider so the vector kernels can read whole vectors past the end.
+class Bitboard {
+private:
+    int width = 0;
+    int height = 0;
+    int guardWords = 0;  // zero words on each side of the board
+    int boardWords = 0;  // words that actually hold cells
+    std::vector<uint64_t> words;
+    const LineKernels* kernels = &LineKernels::scalar();
+
+    // 64 bits of the board starting at bit (64 * w + offset), offset may be negative
+    uint64_t shiftedWord(int w, int offset) const {
+        int bit = (w + guardWords) * 64 + offset;
+        int q = bit >> 6;
+        int r = bit & 63;
+        // (hi << 1) << (63 - r) avoids the undefined shift by 64 when r == 0
+        return (words[q] >> r) | ((words[q + 1] << 1) << (63 - r));
+    }
+
+    static int popcount(uint64_t value) {
+        return static_cast<int>(std::bitset<64>(value).count());
+    }
+
+public:
+    Bitboard() = default;
+
+    // maxRun is the longest line that will ever be scanned (the match length)
+    Bitboard(int width, int height, int maxRun)
+        : width(width), height(height) {
+        int cells = height * (width + 1);
+        int maxShift = (maxRun - 1) * (width + 2);
+        boardWords = (cells + 63) / 64;
+        guardWords = (maxShift + 63) / 64 + 1;
+        words.assign(boardWords + 2 * guardWords + LineKernels::MAX_VECTOR_WORDS - 1, 0);
+        kernels = &LineKernels::active();
+    }
+
+    int stride() const { return width + 1; }
+
+    int index(int x, int y) const { return y * (width + 1) + x; }
+
+    void set(int bit) { words[guardWords + (bit >> 6)] |= 1ULL << (bit & 63); }
+
+    void clear(int bit) { words[guardWords + (bit >> 6)] &= ~(1ULL << (bit & 63)); }
+
+    bool test(int bit) const { return (words[guardWords + (bit >> 6)] >> (bit & 63)) & 1ULL; }
+
+    void reset() { std::fill(words.begin(), words.end(), 0); }
+
+    int count() const {
+        int total = 0;
+        for (int w = 0; w < boardWords; ++w) {
+            total += popcount(words[guardWords + w]);
+        }
+        return total;
+    }
+
+    // Number of cells that start a run of `length` stones, each `step` bits from the last.
+    // Single-word boards stay inline; anything larger goes to the vector kernel.
+    int countRuns(int step, int length) const {
+        if (boardWords > 1) return kernels->countRuns(&words[guardWords], boardWords, step, length);
+        if (length <= 0) return 0;
+        uint64_t acc = words[guardWords];
+        for (int k = 1; k < length && acc; ++k) {
+            acc &= shiftedWord(0, k * step);
+        }
+        return popcount(acc);
+    }
+
+    bool hasRun(int step, int length) const {
+        if (boardWords > 1) return kernels->hasRun(&words[guardWords], boardWords, step, length);
+        if (length <= 0) return false;
+        uint64_t acc = words[guardWords];
+        for (int k = 1; k < length && acc; ++k) {
+            acc &= shiftedWord(0, k * step);
+        }
+        return acc != 0;
+    }
+};
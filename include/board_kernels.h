@@ -0,0 +1,25 @@
+#pragma once
+
+class TicTacToe;
+
+// TicTacToe's board-geometry primitives compiled for one board size and match length.
+// The window and neighbour tables are built at compile time and every directional scan
+// has a fixed trip count, so the compiler unrolls them. forBoard() returns the kernels
+// for the boards we play most (3x3/3, 9x9/5, 15x15/5) and null for any other board,
+// which keeps TicTacToe's runtime loops. Either way the search itself is the same code.
+struct BoardKernels {
+    // Would a stone of player on the cell complete a line? The cell counts whether or not it is placed
+    using IsWinningMove = bool (*)(const TicTacToe& game, int cell, int player);
+    // Window counts after placing or removing player's stone; true if placing it filled a window
+    using UpdateWindows = bool (*)(TicTacToe& game, int cell, int player, bool placed);
+    // Candidate set after placing or removing a stone, for CANDIDATE_RADIUS only
+    using UpdateCandidates = void (*)(TicTacToe& game, int cell, bool placed);
+
+    static constexpr int CANDIDATE_RADIUS = 2;
+
+    IsWinningMove isWinningMove;
+    UpdateWindows updateWindows;
+    UpdateCandidates updateCandidates;
+
+    static const BoardKernels* forBoard(int width, int height, int matchLength);
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include "mapped_file.h"
+
+// Compact binary archive of games. The file is an 8-byte header followed by records
+// back to back, each one:
+//   varint width, varint height, varint matchLength,
+//   varint (cell + 1) per move, cell = (y - 1) * width + (x - 1),
+//   a zero byte that ends the moves, then one result byte.
+// Varints are 7 bits per byte, low bits first, so a move costs one byte on boards up to
+// 127 cells and two up to 16383. The moves end with a terminator rather than starting
+// with a count, which lets GameRecordWriter stream each move out as it is played.
+struct GameRecord {
+    enum Result : uint8_t { UNFINISHED = 0, X_WINS = 1, O_WINS = 2, DRAW = 3 };
+
+    struct Header {
+        char magic[4];  // "TTGR"
+        uint32_t version;
+    };
+    static_assert(sizeof(Header) == 8, "game record header must stay 8 bytes");
+
+    static constexpr uint32_t VERSION = 1;
+
+    // Decodes the moves straight out of the record bytes as 1-indexed (x, y)
+    class MoveIterator {
+    private:
+        const uint8_t* position = nullptr;
+        int width = 1;
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<int, int>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = value_type;
+
+        MoveIterator() = default;
+
+        MoveIterator(const uint8_t* position, int width) : position(position), width(width) {}
+
+        std::pair<int, int> operator*() const;
+
+        MoveIterator& operator++();
+
+        bool operator==(const MoveIterator& other) const { return position == other.position; }
+
+        bool operator!=(const MoveIterator& other) const { return position != other.position; }
+    };
+
+    int width = 0;
+    int height = 0;
+    int matchLength = 0;
+    Result result = UNFINISHED;
+    size_t moveCount = 0;
+    const uint8_t* moveBytes = nullptr;  // first move byte, inside the reader's mapping
+    const uint8_t* moveBytesEnd = nullptr;  // the terminator
+
+    MoveIterator begin() const { return MoveIterator(moveBytes, width); }
+
+    MoveIterator end() const { return MoveIterator(moveBytesEnd, width); }
+
+    // Same text as TicTacToe::getResult for the game
+    std::string toText() const;
+
+    static std::string formatText(const std::vector<std::pair<int, int>>& moves, Result result);
+
+    // Reads getResult text ("1. 2-2 1-1\n2. 3-3\n 1-0") back into its moves and result.
+    // Prints nothing; malformed text returns false with the reason in error, if given.
+    static bool parseText(const std::string& text, std::vector<std::pair<int, int>>& moves, Result& result,
+        std::string* error = nullptr);
+};
+
+// Appends records to a game file. Moves go straight to the file stream as they are
+// added, so nothing holds a whole game in memory. Like the reader, it prints nothing:
+// a failing call returns false with the reason in error, if given.
+class GameRecordWriter {
+private:
+    std::ofstream out;
+    std::string path;
+    int width = 0;
+    int height = 0;
+    bool inGame = false;
+
+    void putVarint(uint32_t value);
+
+public:
+    GameRecordWriter() = default;
+
+    GameRecordWriter(const GameRecordWriter&) = delete;
+
+    GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+    ~GameRecordWriter() { close(); }
+
+    // Opens for appending; a new or empty file gets the header, an existing one must already have it
+    bool open(const std::string& filePath, std::string* error = nullptr);
+
+    bool isOpen() const { return out.is_open(); }
+
+    bool beginGame(int boardWidth, int boardHeight, int matchLength, std::string* error = nullptr);
+
+    bool addMove(int x, int y, std::string* error = nullptr);  // 1-indexed, like TicTacToe::move
+
+    bool endGame(GameRecord::Result result);
+
+    bool writeGame(int boardWidth, int boardHeight, int matchLength,
+        const std::vector<std::pair<int, int>>& moves, GameRecord::Result result, std::string* error = nullptr);
+
+    // Converts one game from getResult text; the text has no board size, so it is passed in
+    bool writeText(const std::string& text, int boardWidth, int boardHeight, int matchLength,
+        std::string* error = nullptr);
+
+    bool flush(std::string* error = nullptr);
+
+    void close();  // a game still open is ended as UNFINISHED
+};
+
+// Iterates the records of a memory-mapped game file. Every GameRecord points into the
+// mapping, so nothing is copied and records stay valid until the reader is closed.
+// Prints nothing; failures return false with the reason in error, if given.
+class GameRecordReader {
+private:
+    MappedFile file;
+    const uint8_t* cursor = nullptr;
+    const uint8_t* end = nullptr;
+
+public:
+    bool open(const std::string& path, std::string* error = nullptr);
+
+    void close();
+
+    bool isOpen() const { return file.isOpen(); }
+
+    // False at the end of the file, or at a truncated or corrupt record; only the latter sets error
+    bool next(GameRecord& record, std::string* error = nullptr);
+
+    void rewind();
+};
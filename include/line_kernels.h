@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+// Run-scanning kernels over the words of a Bitboard, in scalar, SSE2 and AVX2 versions.
+// active() picks the widest one the CPU supports the first time it is called.
+// `words` points at the first board word; the caller guarantees zeroed guard words on
+// both sides wide enough for the largest shift plus one vector (see Bitboard).
+struct LineKernels {
+    using CountRuns = int (*)(const uint64_t* words, int boardWords, int step, int length);
+    using HasRun = bool (*)(const uint64_t* words, int boardWords, int step, int length);
+
+    static constexpr int MAX_VECTOR_WORDS = 4;  // widest kernel reads this many words at once
+
+    CountRuns countRuns;
+    HasRun hasRun;
+    const char* name;
+
+    static const LineKernels& active();
+
+    static const LineKernels& scalar();
+};
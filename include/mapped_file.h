@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file. The pages are shared with every other
+// process mapping the same file, so large data files cost nothing to "load".
+class MappedFile {
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int descriptor = -1;
+#endif
+
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& path) { open(path); }
+
+    MappedFile(const MappedFile&) = delete;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path);
+
+    void close();
+
+    bool isOpen() const { return bytes != nullptr; }
+
+    const uint8_t* data() const { return bytes; }
+
+    size_t size() const { return length; }
+};
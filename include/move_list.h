@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+
+struct ScoredMove {
+    int cell;  // y * boardSizeX + x
+    int score;
+};
+
+// Move list over a buffer owned by someone else, so filling and sorting it never allocates.
+// The search hands every ply its own slice of one preallocated arena; the slice holds a whole
+// board's worth of moves, which bounds any node's move count.
+class MoveList {
+private:
+    ScoredMove* moves = nullptr;
+    int count = 0;
+    int capacity = 0;
+
+public:
+    MoveList() = default;
+
+    MoveList(ScoredMove* buffer, int capacity) : moves(buffer), capacity(capacity) {}
+
+    void add(int cell, int score = 0) {
+        assert(count < capacity);
+        moves[count++] = { cell, score };
+    }
+
+    void clear() { count = 0; }
+
+    void truncate(int size) {
+        assert(size <= count);
+        count = size;
+    }
+
+    int size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    ScoredMove& operator[](int i) { return moves[i]; }
+
+    const ScoredMove& operator[](int i) const { return moves[i]; }
+
+    ScoredMove* begin() { return moves; }
+
+    ScoredMove* end() { return moves + count; }
+
+    const ScoredMove* begin() const { return moves; }
+
+    const ScoredMove* end() const { return moves + count; }
+
+    // Highest score first; std::sort works in place, unlike std::stable_sort. Ties go to the
+    // lower cell, so the order depends only on the scores and not on the order the moves were
+    // generated in (the candidate set's order shifts with every make/undo)
+    void sortByScore() {
+        std::sort(begin(), end(), [](const ScoredMove& a, const ScoredMove& b) {
+            return a.score != b.score ? a.score > b.score : a.cell < b.cell;
+        });
+    }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "game_record.h"
+#include "mapped_file.h"
+
+// A board written as a position string, FEN style: rows from y = 1 down separated by '/',
+// 'x' and 'o' for stones and a number for a run of empty cells, then the side to move and
+// the match length. "x1o/1x1/o2 o 3" is a 3x3 board, O to move, three in a row to win.
+struct ParsedPosition {
+    int width = 0;
+    int height = 0;
+    int matchLength = 0;
+    bool xToMove = true;
+    std::vector<uint8_t> cells;  // row-major, 0 empty, 1 O, 2 X; keeps its capacity between parses
+};
+
+// Hand-written single-pass parsers for position strings and getResult game text. They read
+// straight from a character range without building token strings, so bulk loading costs
+// little beyond reading the file. They print nothing: on malformed text they return false
+// and, if given an error string, describe the problem there.
+class Notation {
+public:
+    // One position string; stops at the end of its line and leaves cursor past the newline
+    static bool parsePosition(const char*& cursor, const char* end, ParsedPosition& position,
+        std::string* error = nullptr);
+
+    // One game in getResult notation ("1. 2-2 1-1\n2. 3-3\n 1-0"), up to and including its
+    // result; a game cut off before its result comes back as UNFINISHED
+    static bool parseGame(const char*& cursor, const char* end,
+        std::vector<std::pair<int, int>>& moves, GameRecord::Result& result, std::string* error = nullptr);
+
+    static std::string formatPosition(const ParsedPosition& position);
+};
+
+// Reads a file of position strings (one per line) or of games in getResult notation back
+// to back, parsing straight from a memory mapping of it
+class NotationReader {
+private:
+    MappedFile file;
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    bool error = false;
+    std::string message;
+
+    bool skipBlank();  // false at the end of the file
+
+    void reportError(const char* start);
+
+public:
+    bool open(const std::string& path);
+
+    void close();
+
+    bool isOpen() const { return file.isOpen(); }
+
+    // Both return false at the end of the file or at the first malformed entry; failed() tells them apart
+    bool nextPosition(ParsedPosition& position);
+
+    bool nextGame(std::vector<std::pair<int, int>>& moves, GameRecord::Result& result);
+
+    bool failed() const { return error; }
+
+    // Why open() or the last entry failed, with the line the entry starts on
+    const std::string& errorMessage() const { return message; }
+};
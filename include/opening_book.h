@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include "mapped_file.h"
+
+// Opening book keyed by the canonical Zobrist hash of a position.
+// The file is a header followed by entries sorted by key, so a lookup is a binary
+// search straight on the memory-mapped file. Moves are stored in the canonical
+// orientation (ZobristKeys::mapCell of the canonical symmetry); a position with
+// several book moves has one entry per move, weighted by how often it was chosen.
+// Zobrist keys come from a fixed seed, so books stay valid across builds and processes.
+class OpeningBook {
+public:
+    struct Entry {
+        uint64_t key;
+        uint16_t move;  // canonical cell index
+        uint16_t weight;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Entry) == 16, "opening book entries must stay 16 bytes");
+
+    struct Header {
+        char magic[4];  // "TTOB"
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t matchLength;
+        uint32_t reserved;
+        uint64_t entryCount;
+    };
+    static_assert(sizeof(Header) == 32, "opening book header must stay 32 bytes");
+
+    static constexpr uint32_t VERSION = 1;
+
+private:
+    MappedFile file;
+    const Entry* entries = nullptr;
+    size_t entryCount = 0;
+    int width = 0;
+    int height = 0;
+    int matchLength = 0;
+
+public:
+    // Prints nothing; a failure returns false with the reason in error, if given
+    bool load(const std::string& path, std::string* error = nullptr);
+
+    bool isLoaded() const { return entries != nullptr; }
+
+    bool matches(int boardWidth, int boardHeight, int length) const {
+        return isLoaded() && width == boardWidth && height == boardHeight && matchLength == length;
+    }
+
+    // Every book move of a position as [first, last); empty if the position is not in the book
+    std::pair<const Entry*, const Entry*> probe(uint64_t key) const;
+
+    size_t size() const { return entryCount; }
+};
+
+// Collects (position, move) pairs in memory and writes them out as a sorted book
+class OpeningBookBuilder {
+private:
+    std::map<std::pair<uint64_t, int>, uint32_t> weights;  // (canonical key, canonical move) -> weight
+
+public:
+    void add(uint64_t key, int move, uint32_t weight = 1);
+
+    bool contains(uint64_t key) const;
+
+    size_t size() const { return weights.size(); }
+
+    bool write(const std::string& path, int width, int height, int matchLength, std::string* error = nullptr) const;  // quiet like load
+};
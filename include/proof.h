@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct ProofResult {
+    enum Value { UNKNOWN, WIN, LOSS, DRAW } value = UNKNOWN;  // for the side to move
+    std::vector<std::pair<int, int>> line;  // proven line from the current position for WIN/LOSS, ending on the winning move
+    bool lineComplete = false;  // false if the node limit ran out while re-proving evicted entries, leaving line cut short
+    unsigned long long nodes = 0;
+};
+
+// Memory-bounded table of proof and disproof numbers for the df-pn solver.
+// Numbers are stored phi/delta style, from the point of view of the side to move:
+// phi = 0 means the side to move reaches its goal, delta = 0 means it cannot.
+// Buckets hold four entries; when a bucket is full, the entry that took the least
+// work to compute is replaced.
+class ProofTable {
+public:
+    static constexpr uint32_t INF = 0x3FFFFFFF;
+
+    struct Entry {
+        uint64_t key = 0;
+        uint32_t phi = 1;
+        uint32_t delta = 1;
+        uint32_t work = 0;  // nodes expanded under this entry, 0 for an empty slot
+    };
+
+private:
+    static constexpr int WAYS = 4;
+    std::vector<Entry> entries;
+    size_t bucketMask = 0;
+
+public:
+    explicit ProofTable(size_t megabytes);
+
+    bool lookup(uint64_t key, Entry& entry) const;
+
+    void store(uint64_t key, uint32_t phi, uint32_t delta, uint32_t work);
+
+    void clear();
+};
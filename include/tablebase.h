@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "mapped_file.h"
+
+// Perfect-play table for boards of at most 16 cells, generated once by retrograde
+// analysis and memory-mapped at runtime.
+// A position's index is sum(cell * 3^i) over the dense cells i = y * width + x, with
+// 0 = empty, 1 = O, 2 = X, so a lookup is a single byte read. Each byte holds the value
+// for the side to move in its low 2 bits and the plies until the game ends under
+// perfect play in the upper 6 (0 for draws). Unreachable positions read as UNKNOWN.
+class Tablebase {
+public:
+    enum Value { UNKNOWN = 0, WIN = 1, LOSS = 2, DRAW = 3 };
+
+    static constexpr int MAX_CELLS = 16;
+
+    // Enumerates every reachable position of the given game and writes its table to path.
+    // Like load, prints nothing: a failure returns false with the reason in error, if given.
+    static bool generate(int width, int height, int matchLength, const std::string& path,
+        std::string* error = nullptr);
+
+    static Value valueOf(uint8_t entry) { return static_cast<Value>(entry & 3); }
+
+    static int distanceOf(uint8_t entry) { return entry >> 2; }
+
+    static uint64_t cellWeight(int cell) {
+        uint64_t weight = 1;
+        while (cell-- > 0) weight *= 3;
+        return weight;
+    }
+
+private:
+    struct Header {
+        char magic[4];  // "TTTB"
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t matchLength;
+        uint32_t reserved;
+        uint64_t entryCount;
+    };
+    static_assert(sizeof(Header) == 32, "tablebase header must stay 32 bytes");
+
+    static constexpr uint32_t VERSION = 1;
+
+    MappedFile file;
+    const uint8_t* entries = nullptr;
+    uint64_t entryCount = 0;
+    int width = 0;
+    int height = 0;
+    int matchLength = 0;
+
+public:
+    bool load(const std::string& path, std::string* error = nullptr);
+
+    bool isLoaded() const { return entries != nullptr; }
+
+    bool matches(int boardWidth, int boardHeight, int length) const {
+        return isLoaded() && width == boardWidth && height == boardHeight && matchLength == length;
+    }
+
+    uint8_t probe(uint64_t index) const { return index < entryCount ? entries[index] : 0; }
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque.
+// Submitted tasks are dealt round-robin; a worker takes from the back of its own
+// deque and, once that is empty, steals from the front of the others, so a few long
+// tasks on one worker do not leave the rest idle. Tasks receive the index of the
+// worker running them, which callers use to keep per-worker state without locking.
+class WorkStealingPool {
+public:
+    using Task = std::function<void(int worker)>;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> nextQueue{ 0 };
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    size_t queued = 0;  // tasks sitting in a deque
+    size_t pending = 0;  // tasks submitted but not finished
+    bool stopping = false;
+
+    bool tryPop(int worker, Task& task);
+
+    void run(int worker);
+
+public:
+    explicit WorkStealingPool(int threadCount = 0);  // 0 uses every hardware thread
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool();
+
+    int size() const { return static_cast<int>(threads.size()); }
+
+    void submit(Task task);
+
+    void wait();  // blocks until every submitted task has finished
+};
@@ -6,37 +6,124 @@
 #include <algorithm>
 #include <cmath>
 #include <stack>
-#include <regex>
-#include <sstream>
 #include <unordered_map>
-#include <random>
+#include <memory>
+#include <chrono>
+#include <limits>
+#include <atomic>
+#include <functional>
+
+#include "bitboard.h"
+#include "board_kernels.h"
+#include "game_record.h"
+#include "notation.h"
+#include "move_list.h"
+#include "opening_book.h"
+#include "proof.h"
+#include "tablebase.h"
+#include "transposition.h"
+#include "zobrist.h"
+
+struct SearchLimits {
+    int maxDepth = 64;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    unsigned long long maxNodes = 0;  // 0 means no node limit
+
+    static SearchLimits withMoveTime(std::chrono::milliseconds budget) {
+        SearchLimits limits;
+        limits.deadline = std::chrono::steady_clock::now() + budget;
+        return limits;
+    }
+};
 
-struct TTEntry {
-    int score;  // cached score
-    int depth;  // depth at which the score was computed
-    enum BoundType { EXACT, LOWER, UPPER } flag;  // bounds
+// What the last getBestMove did; counters cover every search thread
+struct SearchStats {
+    struct Iteration {
+        int depth = 0;
+        std::pair<int, int> bestMove = { -1, -1 };
+        int score = 0;
+        unsigned long long nodes = 0;  // total so far, not just this depth
+        double seconds = 0;  // since the search started
+    };
+
+    unsigned long long nodes = 0;
+    unsigned long long ttProbes = 0;
+    unsigned long long ttHits = 0;
+    unsigned long long ttCutoffs = 0;  // hits whose bound ended the node straight away
+    unsigned long long betaCutoffs = 0;
+    unsigned long long firstMoveCutoffs = 0;  // beta cutoffs caused by the first move searched
+    double seconds = 0;
+    std::string reason;  // why the move was chosen: "Search", "Immediate win", "Tablebase", ...
+    std::vector<Iteration> iterations;  // one per completed depth
+
+    double nodesPerSecond() const { return seconds > 0 ? nodes / seconds : 0; }
+
+    // Share of beta cutoffs found on the first move, a measure of move ordering quality
+    double firstMoveCutoffRatio() const { return betaCutoffs ? static_cast<double>(firstMoveCutoffs) / betaCutoffs : 0; }
+
+    void addCounters(const SearchStats& other) {
+        ttProbes += other.ttProbes;
+        ttHits += other.ttHits;
+        ttCutoffs += other.ttCutoffs;
+        betaCutoffs += other.betaCutoffs;
+        firstMoveCutoffs += other.firstMoveCutoffs;
+    }
 };
+
+using SearchInfoCallback = std::function<void(const SearchStats::Iteration&)>;
+
 class TicTacToe {
 private:
-    std::unordered_map<unsigned long long, TTEntry> transpositionTable;  // transposition table
-    unsigned long long zobristTable[100][100][3];  // Zobrist table for N x N (max 100x100)
-    unsigned long long boardHash = 0;
+    friend class EngineBenchmark;  // tools/bench times the private primitives directly
+    template <int W, int H, int K> friend struct FixedBoardKernels;  // compiled geometry, src/board_kernels.cpp
 
-    void initializeZobrist();  // Initialize Zobrist table
-    void updateHash(int x, int y, int player);  // Update hash for moves
+    // Shared by the root thread and its helpers while a search is running
+    struct SearchControl {
+        std::chrono::steady_clock::time_point deadline;
+        unsigned long long maxNodes = 0;
+        std::atomic<unsigned long long> nodes{ 0 };
+        std::atomic<bool> stopped{ false };
+    };
+
+    static constexpr int SEARCH_INF = std::numeric_limits<int>::max();
+    static constexpr int ASPIRATION_WINDOW = 50;
+    static constexpr int MAX_ASPIRATION_WINDOW = 5000;  // beyond this the window just opens fully
+    static constexpr unsigned long long SEARCH_POLL_INTERVAL = 1024;  // nodes between limit checks
 
-    std::string hashBoard(const std::vector<std::vector<int>>& boardCopy) const;
+    SearchControl* searchControl = nullptr;
+    unsigned long long nodeAllowance = 0;  // totalNodes may reach this before the next pollSearchLimits
 
-    std::vector<std::vector<int>> rotateBoard90(const std::vector<std::vector<int>>& boardCopy) const;
+    // Allocated on the first search; copies of a game share it with the original
+    std::shared_ptr<TranspositionTable> transpositionTable;
+    size_t hashSizeMB = 16;
+    std::shared_ptr<const ZobristKeys> zobrist;  // shared by every game with the same dimensions
+    unsigned long long boardHashes[ZobristKeys::MAX_SYMMETRIES] = {};  // boardHashes[t]: hash of the board under symmetry t
 
-    std::vector<std::vector<int>> reflectBoardHorizontal(const std::vector<std::vector<int>>& boardCopy) const;
+    std::shared_ptr<const Tablebase> tablebase;  // perfect play for small boards, null if none is loaded
+
+    bool probeTablebase(int player, std::pair<int, int>& bestMove) const;
+
+    std::shared_ptr<const OpeningBook> openingBook;
+    static constexpr uint64_t DEFAULT_BOOK_SEED = 0x9E3779B97F4A7C15ULL;
+    uint64_t bookRandomState = DEFAULT_BOOK_SEED;  // xorshift64* state, picks among weighted book moves
+
+    uint32_t nextBookRandom(uint32_t bound);  // uniform in [0, bound)
+
+    bool probeOpeningBook(int player, std::pair<int, int>& bestMove);
+
+    void initializeZobrist();  // Look up the shared Zobrist keys
+    void updateHash(int x, int y, int player);  // Update hash for moves
 
-    std::string normalizeBoard() const;
+    int canonicalSymmetry() const;  // symmetry whose hash is the smallest
+
+    unsigned long long canonicalHash() const;  // same value for every symmetric image of the position
 
     int countLines(int player, int length) const;
 
     std::vector<std::pair<int, int>> getOrderedMoves(int player);
 
+    std::vector<std::pair<int, int>> getOrderedMoves(int player, const std::vector<std::pair<int, int>>& moves);
+
 
     static constexpr int MIN_BOARD_SIZE = 3;
     int boardSizeX;
@@ -46,10 +133,47 @@ private:
     bool isPositionInvalid;
     bool isDraw;
     std::string winner;
-    std::vector<std::vector<int>> board;
+    Bitboard stones[2];  // stones[player - 1], 1 = O, 2 = X
+    int lineSteps[4];  // bit offsets for the {1, 0}, {0, 1}, {1, 1}, {1, -1} directions
+
+    // Every matchLength window on the board, built once in the constructor.
+    // Cells are indexed y * boardSizeX + x.
+    int windowCount = 0;
+    std::vector<int> windowCells;  // windowCount * matchLength cells
+    std::vector<int> cellWindowStart;  // cellWindows[cellWindowStart[c] .. cellWindowStart[c + 1]) hold c's windows
+    std::vector<int> cellWindows;
+    std::vector<int> windowStones[2];  // stones per window, indexed by player - 1
+    std::vector<int> openWindows[2];  // openWindows[p][k]: windows with k stones of p and none of the opponent
+    int potentialWindows[2] = { 0, 0 };  // open windows that still have an empty cell
+
+    const BoardKernels* boardKernels = nullptr;  // compiled geometry for this board, null to use the runtime loops
+
+    // Search candidates: empty cells within candidateRadius (Chebyshev) of a stone
+    int candidateRadius = 2;
+
+    int threatSearchDepth = 8;  // attacker moves the pre-search threat solver may read ahead
+    std::vector<int> nearbyStones;  // stones within the radius of each cell
+    std::vector<int> candidateCells;  // unordered set of candidate cells
+    std::vector<int> candidateSlot;  // position of each cell in candidateCells, -1 if absent
     std::stack<std::pair<int, int>> currentLine;
     int moveNumber;
-    int currentNode, totalNodes;
+    unsigned long long currentNode, totalNodes;
+    int searchThreads = 1;
+
+    // Move ordering state, cleared at the start of every search
+    static constexpr int STATIC_ORDERING_PLIES = 2;  // plies that still use the full scoreMove ordering
+    std::vector<int> killerMoves;  // two cells per ply, -1 when empty
+    std::vector<int> historyScores[2];  // per player, per cell: depth^2 summed over beta cutoffs
+
+    // Move lists for the search, one board-sized slice per ply, so negamax never allocates
+    std::vector<ScoredMove> moveArena;
+
+    void reserveSearchScratch(int maxDepth);  // called before a search, grows moveArena if needed
+
+    MoveList plyMoveList(int ply);
+    int stoneCount = 0;  // stones on the board, including search moves
+    int winnerPlayer = 0;  // player who completed a line, 0 if none yet
+    int winPly = -1;  // stoneCount at which winnerPlayer won, so undoMove can restore it
 
     std::vector<std::pair<int, int>> previousMoves;
 
@@ -57,6 +181,22 @@ private:
 
     void fillBoard();
 
+    int cellAt(int x, int y) const;  // 0-indexed, returns 0, 1 or 2
+
+    void buildWindows();
+
+    void adjustOpenWindows(int playerIndex, int stones, int delta);
+
+    bool updateWindows(int cell, int player, bool placed);  // true if placing the stone filled a window
+
+    void addCandidate(int cell);
+
+    void removeCandidate(int cell);
+
+    void updateCandidates(int cell, bool placed);
+
+    void rebuildCandidates();
+
     bool checkLines(int symbol);
 
     bool checkDiagonals(int symbol);
@@ -65,22 +205,121 @@ private:
 
     void makeMove(int x, int y, int player);
 
+    void commitMove(int x, int y);  // plays a legal move for the side to move and records it
+
+    bool replayMove(int x, int y, std::string* error);  // commitMove after a silent legality check
+
+    bool checkRecordedResult(GameRecord::Result result, std::string* error) const;
+
     void undoMove(int x, int y);
 
+    bool isWinningMove(int x, int y, int player) const;  // would placing here complete a line?
+
+    bool isTerminal() const;
+
     void printCurrentLine(int score) const;
 
-    std::vector<std::pair<std::pair<int, int>, int>> getScoredMoves(int player, std::pair<int, int> prioritizedMove);
+    void getScoredMoves(MoveList& moves, int player, int prioritizedCell);
 
     int scoreMove(const std::pair<int, int>& move, int player);
 
     int calculateDepth(int maxDepth);
 
-    int minimax(int depth, bool isMaximizing, int alpha, int beta);
+    int negamax(int depth, int ply, int alpha, int beta, int player);
+
+    void resetMoveOrdering();
+
+    void getSearchMoves(MoveList& moves, int player, int ply, int ttMove);
+
+    void recordCutoff(int player, int ply, int cell, int depth);
+
+    // Helper threads' copies of the engine, kept from one search to the next so a search
+    // only has to copy the position into them. A copied or assigned game starts without any.
+    struct SearchWorkers {
+        std::vector<TicTacToe> engines;
+
+        SearchWorkers() = default;
+
+        SearchWorkers(const SearchWorkers&) {}
+
+        SearchWorkers& operator=(const SearchWorkers&) { return *this; }
+    };
+
+    SearchWorkers searchWorkers;
+
+    // Returns the index of the best root move (-1 if none finished) and its score
+    std::pair<int, int> searchRoot(const MoveList& moves, int depth,
+        int player, int alpha, int beta, std::vector<TicTacToe>& workers);
+
+    // Takes the next block of nodes from searchControl and checks the clock; sets stopped
+    // once either limit is used up
+    void pollSearchLimits();
+
+    bool countSearchNode();  // counts a node about to be searched, false if the search must stop instead
+
+    void releaseSearchNodes();  // hands the unsearched rest of this copy's block back to searchControl
+
+    // Checks the clock now rather than at the next block, for work that costs as much as
+    // hundreds of ordinary nodes; true if the search must stop
+    bool searchDeadlinePassed();
+
+    // Static ordering of the root moves, one node per move scored. If the limits run out
+    // part way, the moves not yet scored stay behind the scored ones
+    void orderRootMoves(int player, MoveList& moves);
+
+    SearchStats stats;
+    bool verbose = false;  // log each search to std::cout, off unless setVerbose(true)
+    SearchInfoCallback infoCallback;
+
+    // Fills in the final stats (and logs the move when verbose) on every exit from getBestMove
+    std::pair<int, int> finishSearch(const std::pair<int, int>& move, const std::string& reason,
+        std::chrono::steady_clock::time_point start);
+
+    // Empty cells of windows holding stonesInWindow of player's stones and none of the opponent's
+    void collectThreatCells(int player, int stonesInWindow, std::vector<int>& cells) const;
+
+    // Stops early, returning false, when searchControl says so
+    bool searchThreats(int attacker, int depthLeft, std::vector<int>& line);
+
+    std::vector<std::vector<int>> threatBuffers;  // three scratch cell lists per threat search depth
+
+    // State of one df-pn run; see proof.cpp
+    struct ProofSearch {
+        ProofTable table;
+        int attacker = 0;
+        unsigned long long nodes = 0;
+        unsigned long long maxNodes = 0;
+        bool aborted = false;
+
+        explicit ProofSearch(size_t tableMB) : table(tableMB) {}
+    };
+
+    unsigned long long childHash(int cell, int player) const;  // canonical hash after player takes cell
+
+    bool proofTerminal(int player, int attacker, uint32_t& phi, uint32_t& delta) const;
+
+    int findWinningCell(int player) const;
+
+    void proofChildren(int player, std::vector<std::pair<int, unsigned long long>>& children) const;
+
+    void proofSearch(ProofSearch& search, int player, uint32_t thresholdPhi, uint32_t thresholdDelta);
+
+    bool proofLine(ProofSearch& search, int player, std::vector<std::pair<int, int>>& line);
 
     int evaluatePosition(bool isMaximizing);
 
     std::vector<std::pair<int, int>> getAvailableMoves();
 
+    void generateMoves(MoveList& moves) const;  // same cells, same order as getAvailableMoves
+
+    // Symmetries that map the current position onto itself, written to symmetries
+    // (room for MAX_SYMMETRIES); returns how many
+    int getPositionSymmetries(int* symmetries) const;
+
+    void generateUniqueMoves(MoveList& moves) const;  // generateMoves, one cell per symmetry class
+
+    std::vector<std::pair<int, int>> getSymmetryUniqueMoves();  // one available move per symmetry class
+
     bool isLineBlocked(int x, int y, int player);
 
     bool isStrandedPiece(const std::pair<int, int>& move, int player);
@@ -89,13 +328,14 @@ private:
 
     int countThreatsBlocked(int x, int y, int opponent);
 
-    void printDebugInfo(int depth, const std::vector<std::pair<int, int>>& moves, int player);
-
-    bool isPotentialWinningLine(const std::vector<std::pair<int, int>>& line, int player);
-
     int countPotentialWinningLines(int player);
 
+    unsigned long long perftFrom(int depth, int player);
+
 public:
+    static constexpr int WIN_SCORE = 100000000;  // score of a win on the board, minus its distance in plies
+    static constexpr int WIN_THRESHOLD = WIN_SCORE / 2;  // anything beyond this is a forced win or loss
+
     bool isXTurn;
     bool isOTurn;
     TicTacToe(int boardSizeX, int boardSizeY, int matchLength)
@@ -107,7 +347,6 @@ public:
         isOTurn(false),
         isPositionInvalid(false),
         isDraw(false),
-        boardHash(0),
         winner(""),
         moveNumber(0),
         currentNode(0),
@@ -115,12 +354,20 @@ public:
         if (this->boardSizeX < matchLength || this->boardSizeY < matchLength) {
             throw std::invalid_argument("Invalid match length");
         }
+        buildWindows();
+        boardKernels = BoardKernels::forBoard(this->boardSizeX, this->boardSizeY, this->matchLength);
         fillBoard();
         initializeZobrist();
     }
 
     bool move(int x, int y);
 
+    int getWidth() const { return boardSizeX; }
+
+    int getHeight() const { return boardSizeY; }
+
+    int getMatchLength() const { return matchLength; }
+
     std::string ascii() const;
 
     bool isOver() const;
@@ -133,7 +380,94 @@ public:
 
     std::string getResult();
 
+    // Appends the game so far, with its result, to a record file; quiet like the writer
+    bool writeRecord(GameRecordWriter& writer, std::string* error = nullptr) const;
+
+    // The loaders below print nothing. They return false with the reason in error, if given,
+    // and leave the board as it was when the input is unreadable or for another board, or
+    // empty when it fails part way through.
+
+    // Resets the board and replays a record. Fails on an illegal move, or on a result the
+    // final board contradicts; a draw only claims that nobody has won.
+    bool loadRecord(const GameRecord& record, std::string* error = nullptr);
+
+    // Resets the board and replays 1-indexed moves from the empty board, X first; fails like loadRecord
+    bool loadMoves(const std::vector<std::pair<int, int>>& moves, std::string* error = nullptr);
+
+    // Sets up the board from a position string (see notation.h) without any move history.
+    // The position must be for this board size and match length and reachable in play:
+    // X moves first, only the side that just moved can have a line, and all of its lines
+    // must run through one stone, the one it just played.
+    bool loadPosition(const std::string& position, std::string* error = nullptr);
+
+    bool loadPosition(const ParsedPosition& position, std::string* error = nullptr);
+
+    std::string getPosition() const;
+
+    // Resets the board and replays a game in getResult notation, checked like loadRecord
+    bool loadGame(const std::string& text, std::string* error = nullptr);
+
     std::pair<int, int> getBestMove(int depth, bool isMaximizing);
 
+    // Iterative deepening until the depth, deadline or node limit runs out;
+    // returns the best move of the last fully searched depth
+    std::pair<int, int> getBestMove(const SearchLimits& limits, bool isMaximizing);
+
+    // 0 uses every hardware thread. With more than one, the threads split the root moves
+    // and race on shared bounds and the shared table, so the move and score can differ
+    // from a single-threaded search of the same depth, and from run to run.
+    void setSearchThreads(int threads);
+
+    int getSearchThreads() const;
+
+    void setHashSize(size_t megabytes);
+
+    void setCandidateRadius(int radius);  // 0 searches every empty cell
+
+    void setThreatSearchDepth(int depth);  // 0 skips the threat solver in getBestMove
+
+    // Forced win built only from moves that threaten to complete a line, as alternating
+    // attacker/defender moves ending on the winning move; empty if none is found
+    std::vector<std::pair<int, int>> findThreatSequence(bool isMaximizing, int maxDepth);
+
+    // Exact game-theoretic value of the current position for the side to move, found
+    // with df-pn over every empty cell. maxNodes = 0 means no limit; UNKNOWN if it runs out.
+    ProofResult solve(unsigned long long maxNodes = 0, size_t tableMB = 64);
+
+    void clearHash();
+
+    // Maps a table written by Tablebase::generate for this board; getBestMove then
+    // answers from it without searching. Prints nothing; a failure returns false with the
+    // reason in error, if given, and keeps the table loaded before
+    bool loadTablebase(const std::string& path, std::string* error = nullptr);
+
+    // Maps a book written by OpeningBookBuilder; getBestMove plays its moves while the
+    // position is in it, chosen at random in proportion to their weights. Quiet like
+    // loadTablebase, and a failure keeps the book loaded before
+    bool loadOpeningBook(const std::string& path, std::string* error = nullptr);
+
+    void setBookSeed(uint64_t seed);  // book choices are reproducible for a given seed
+
+    void addBookMove(OpeningBookBuilder& book, std::pair<int, int> move, uint32_t weight = 1) const;
+
+    // Adds the first maxPlies moves of a game record played from the current position
+    void addBookGame(OpeningBookBuilder& book, const std::vector<std::pair<int, int>>& moves, int maxPlies);
+
+    // Adds the searched best move of every position up to `plies` moves from the current
+    // one, branching over every symmetry-unique move; positions already in the book are not searched again
+    void searchBookMoves(OpeningBookBuilder& book, int plies, int depth);
+
     int analyzeLastMove();
+
+    unsigned long long getNodeCount() const { return totalNodes; }  // nodes visited by the last getBestMove
+
+    const SearchStats& getSearchStats() const { return stats; }  // of the last getBestMove
+
+    void setVerbose(bool enabled);  // true logs each depth and the chosen move of getBestMove to std::cout
+
+    void setSearchInfoCallback(SearchInfoCallback callback);  // called after every completed depth
+
+    // Number of move sequences of `depth` plies from the current position, over every
+    // empty cell; a game that ends early counts as one leaf. 3x3 to the end gives 255168.
+    unsigned long long perft(int depth);
 };
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct TTEntry {
+    int score;  // cached score
+    int depth;  // depth at which the score was computed
+    enum BoundType { EXACT, LOWER, UPPER } flag;  // bounds
+    int move;  // best move as a cell index (y * boardSizeX + x), -1 if none
+};
+
+// Fixed-size transposition table that every search thread can share.
+// The table is a power-of-two number of buckets with two slots each: the first slot
+// keeps the deepest result (unless it is left over from an older search), the second
+// always takes the newest one. Slots store (key ^ data, data), so when two threads race
+// on the same slot a torn write fails the key check instead of returning another
+// position's score.
+class TranspositionTable {
+private:
+    struct Slot {
+        std::atomic<uint64_t> check;  // key ^ data
+        std::atomic<uint64_t> data;  // packed entry, 0 when empty
+    };
+
+    struct Bucket {
+        Slot slots[2];  // depth-preferred, always-replace
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketCount = 0;
+    uint64_t generation = 0;  // bumped by newSearch(), stored in 6 bits
+
+    static uint64_t pack(const TTEntry& entry, uint64_t generation);
+
+    static TTEntry unpack(uint64_t data);
+
+    static int depthOf(uint64_t data);
+
+    static uint64_t generationOf(uint64_t data);
+
+public:
+    explicit TranspositionTable(size_t megabytes = 16);
+
+    void resize(size_t megabytes);  // drops every entry
+
+    void clear();
+
+    void newSearch();
+
+    bool probe(uint64_t key, TTEntry& entry) const;
+
+    void store(uint64_t key, const TTEntry& entry);
+
+    size_t sizeInBytes() const;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Zobrist keys for one board size.
+// Keys come from a fixed seed, so hashes are reproducible across runs and processes,
+// and every game with the same dimensions shares a single instance through forBoard().
+//
+// The keys are also stored once per board symmetry: key(t, cell, player) is the key of
+// the cell that `cell` lands on under symmetry t. XOR-ing them gives the hash of the
+// transformed board, so a game can keep all of its symmetric hashes incrementally.
+// Symmetries 0-3 (identity, mirror x, mirror y, rotate 180) fit every board; square
+// boards also get 4-7 (transpose, rotate 90, rotate 270, anti-transpose).
+//
+// sideKey() is XOR-ed in when O is to move. Board hashes leave it out (the opening book
+// and the proof search keep their own notion of the side), but search scores are relative
+// to the side to move, so the transposition table key must include it.
+class ZobristKeys {
+private:
+    int cells;
+    int symmetries;
+    std::vector<uint64_t> keys;  // per symmetry, two keys per cell, indexed cell * 2 + player - 1
+    std::vector<int> cellMaps;  // cellMaps[t * cells + c]: where cell c lands under symmetry t
+    std::vector<int> inverseMaps;
+    uint64_t side;
+
+public:
+    static constexpr int MAX_SYMMETRIES = 8;
+
+    ZobristKeys(int width, int height);
+
+    static std::shared_ptr<const ZobristKeys> forBoard(int width, int height);
+
+    int symmetryCount() const { return symmetries; }
+
+    // cell is y * width + x, player is 1 or 2
+    uint64_t key(int symmetry, int cell, int player) const {
+        return keys[(static_cast<size_t>(symmetry) * cells + cell) * 2 + player - 1];
+    }
+
+    uint64_t sideKey() const { return side; }
+
+    int mapCell(int symmetry, int cell) const { return cellMaps[symmetry * cells + cell]; }
+
+    int unmapCell(int symmetry, int cell) const { return inverseMaps[symmetry * cells + cell]; }
+};
@@ -0,0 +1,55 @@
+#include "../include/batch.h"
+
+BatchAnalyzer::BatchAnalyzer(const BatchOptions& options)
+    : options(options), pool(options.threads) {
+    engines.resize(pool.size());
+}
+
+BatchResult BatchAnalyzer::analyzePosition(int worker, size_t index, const BatchPosition& position) {
+    BatchResult result;
+    result.index = index;
+    auto start = std::chrono::steady_clock::now();
+
+    auto& engine = engines[worker][EngineKey(position.boardSizeX, position.boardSizeY, position.matchLength)];
+    if (!engine) {
+        try {
+            engine = std::make_unique<TicTacToe>(position.boardSizeX, position.boardSizeY, position.matchLength);
+        }
+        catch (const std::invalid_argument& e) {
+            engines[worker].erase(EngineKey(position.boardSizeX, position.boardSizeY, position.matchLength));
+            result.error = e.what();
+            return result;
+        }
+        engine->setHashSize(options.hashSizeMB);
+        engine->setVerbose(false);
+    }
+
+    // Workers run side by side, so the replay must not print; the reason goes in the result
+    TicTacToe& game = *engine;
+    if (!game.loadMoves(position.moves, &result.error)) return result;
+    if (game.isOver()) {
+        result.error = "The game is already over";
+        return result;
+    }
+
+    SearchLimits limits = options.moveTimeMs > 0 ? SearchLimits::withMoveTime(std::chrono::milliseconds(options.moveTimeMs)) : SearchLimits();
+    limits.maxDepth = options.maxDepth;
+    limits.maxNodes = options.maxNodes;
+    result.bestMove = game.getBestMove(limits, game.isXTurn);
+    result.valid = result.bestMove.first > 0;
+    result.stats = game.getSearchStats();
+
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void BatchAnalyzer::analyze(const std::vector<BatchPosition>& positions, const ResultCallback& onResult) {
+    for (size_t i = 0; i < positions.size(); ++i) {
+        pool.submit([this, i, &positions, &onResult](int worker) {
+            BatchResult result = analyzePosition(worker, i, positions[i]);
+            std::lock_guard<std::mutex> lock(resultMutex);
+            onResult(result);
+        });
+    }
+    pool.wait();
+}
@@ -0,0 +1,167 @@
+#include "../include/board_kernels.h"
+#include "../include/tictactoe.h"
+
+#include <array>
+
+namespace {
+
+// Geometry of a W x H board with K in a row, computed at compile time. Windows are
+// numbered exactly as TicTacToe::buildWindows numbers them, so window indices can be
+// used on the game's windowStones directly.
+template <int W, int H, int K>
+struct BoardGeometry {
+    static constexpr int CELLS = W * H;
+    static constexpr int MAX_CELL_WINDOWS = 4 * K;
+    static constexpr int RADIUS = BoardKernels::CANDIDATE_RADIUS;
+    static constexpr int MAX_NEARBY = (2 * RADIUS + 1) * (2 * RADIUS + 1);
+
+    std::array<int, CELLS> cellWindowCount{};
+    std::array<std::array<int, MAX_CELL_WINDOWS>, CELLS> cellWindows{};
+    std::array<int, CELLS> nearbyCount{};
+    std::array<std::array<int, MAX_NEARBY>, CELLS> nearbyCells{};  // the cell itself and every cell within RADIUS
+    std::array<std::array<int, MAX_NEARBY>, CELLS> nearbyBits{};  // the same cells as Bitboard bits
+
+    constexpr BoardGeometry() {
+        const int directions[4][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, -1 } };
+        int window = 0;
+        for (const auto& dir : directions) {
+            for (int y = 0; y < H; ++y) {
+                for (int x = 0; x < W; ++x) {
+                    int endX = x + (K - 1) * dir[0];
+                    int endY = y + (K - 1) * dir[1];
+                    if (endX < 0 || endY < 0 || endX >= W || endY >= H) continue;
+                    for (int k = 0; k < K; ++k) {
+                        int cell = (y + k * dir[1]) * W + (x + k * dir[0]);
+                        cellWindows[cell][cellWindowCount[cell]++] = window;
+                    }
+                    ++window;
+                }
+            }
+        }
+
+        for (int cell = 0; cell < CELLS; ++cell) {
+            int cx = cell % W, cy = cell / W;
+            for (int y = cy - RADIUS; y <= cy + RADIUS; ++y) {
+                for (int x = cx - RADIUS; x <= cx + RADIUS; ++x) {
+                    if (x < 0 || y < 0 || x >= W || y >= H) continue;
+                    nearbyCells[cell][nearbyCount[cell]] = y * W + x;
+                    nearbyBits[cell][nearbyCount[cell]] = y * (W + 1) + x;
+                    ++nearbyCount[cell];
+                }
+            }
+        }
+    }
+};
+
+}  // namespace
+
+// Declared a friend of TicTacToe; each function mirrors the runtime version it replaces
+template <int W, int H, int K>
+struct FixedBoardKernels {
+    static constexpr BoardGeometry<W, H, K> geometry{};
+
+    // Bit offsets of the {1, 0}, {0, 1}, {1, 1}, {1, -1} directions with the (W + 1) stride
+    static constexpr int steps[4] = { 1, W + 1, W + 2, -W };
+
+    static bool isWinningMove(const TicTacToe& game, int cell, int player) {
+        // The empty stride column and the guard words read as empty, so the walk
+        // needs no bounds checks and its length is known to the compiler
+        const Bitboard& own = game.stones[player - 1];
+        int bit = (cell / W) * (W + 1) + cell % W;
+        for (int step : steps) {
+            int run = 1;
+            for (int k = 1; k < K && own.test(bit + k * step); ++k) run++;
+            for (int k = 1; k < K && own.test(bit - k * step); ++k) run++;
+            if (run >= K) return true;
+        }
+        return false;
+    }
+
+    static void adjustOpenWindows(int* open, int& potential, int stones, int delta) {
+        open[stones] += delta;
+        if (stones < K) potential += delta;
+    }
+
+    static bool updateWindows(TicTacToe& game, int cell, int player, bool placed) {
+        int own = player - 1;
+        int other = 1 - own;
+        int* ownStones = game.windowStones[own].data();
+        int* otherStones = game.windowStones[other].data();
+        int* ownOpen = game.openWindows[own].data();
+        int* otherOpen = game.openWindows[other].data();
+        int& ownPotential = game.potentialWindows[own];
+        int& otherPotential = game.potentialWindows[other];
+        bool completed = false;
+
+        for (int i = 0; i < geometry.cellWindowCount[cell]; ++i) {
+            int w = geometry.cellWindows[cell][i];
+            int ownCount = ownStones[w];
+            int otherCount = otherStones[w];
+
+            if (placed) {
+                if (otherCount == 0) {
+                    adjustOpenWindows(ownOpen, ownPotential, ownCount, -1);
+                    adjustOpenWindows(ownOpen, ownPotential, ownCount + 1, 1);
+                    completed |= ownCount + 1 == K;
+                }
+                if (ownCount == 0) adjustOpenWindows(otherOpen, otherPotential, otherCount, -1);
+                ownStones[w] = ownCount + 1;
+            }
+            else {
+                if (otherCount == 0) {
+                    adjustOpenWindows(ownOpen, ownPotential, ownCount, -1);
+                    adjustOpenWindows(ownOpen, ownPotential, ownCount - 1, 1);
+                }
+                if (ownCount == 1) adjustOpenWindows(otherOpen, otherPotential, otherCount, 1);
+                ownStones[w] = ownCount - 1;
+            }
+        }
+        return completed;
+    }
+
+    static void updateCandidates(TicTacToe& game, int cell, bool placed) {
+        int* nearby = game.nearbyStones.data();
+        const Bitboard& o = game.stones[0];
+        const Bitboard& x = game.stones[1];
+
+        if (placed) game.removeCandidate(cell);
+        for (int i = 0; i < geometry.nearbyCount[cell]; ++i) {
+            int neighbour = geometry.nearbyCells[cell][i];
+            if (placed) {
+                int bit = geometry.nearbyBits[cell][i];
+                if (++nearby[neighbour] == 1 && !o.test(bit) && !x.test(bit)) game.addCandidate(neighbour);
+            }
+            else if (--nearby[neighbour] == 0) {
+                game.removeCandidate(neighbour);
+            }
+        }
+        if (!placed && nearby[cell] > 0) game.addCandidate(cell);
+    }
+};
+
+namespace {
+
+struct CompiledBoard {
+    int width;
+    int height;
+    int matchLength;
+    BoardKernels kernels;
+};
+
+const CompiledBoard COMPILED_BOARDS[] = {
+    { 3, 3, 3, { &FixedBoardKernels<3, 3, 3>::isWinningMove, &FixedBoardKernels<3, 3, 3>::updateWindows,
+        &FixedBoardKernels<3, 3, 3>::updateCandidates } },
+    { 9, 9, 5, { &FixedBoardKernels<9, 9, 5>::isWinningMove, &FixedBoardKernels<9, 9, 5>::updateWindows,
+        &FixedBoardKernels<9, 9, 5>::updateCandidates } },
+    { 15, 15, 5, { &FixedBoardKernels<15, 15, 5>::isWinningMove, &FixedBoardKernels<15, 15, 5>::updateWindows,
+        &FixedBoardKernels<15, 15, 5>::updateCandidates } },
+};
+
+}  // namespace
+
+const BoardKernels* BoardKernels::forBoard(int width, int height, int matchLength) {
+    for (const auto& board : COMPILED_BOARDS) {
+        if (board.width == width && board.height == height && board.matchLength == matchLength) return &board.kernels;
+    }
+    return nullptr;
+}
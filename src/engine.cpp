@@ -1,147 +1,480 @@
 #include "../include/tictactoe.h"
 #include <future>
 #include <thread>
-
-std::random_device rd;
+#include <atomic>
+#include <mutex>
+#include <cassert>
 
 void TicTacToe::initializeZobrist() {
-    std::mt19937_64 rng(rd());
-    for (int y = 0; y < boardSizeY; ++y) {
-        for (int x = 0; x < boardSizeX; ++x) {
-            for (int p = 0; p < 3; ++p) {
-                zobristTable[x][y][p] = rng();
+    zobrist = ZobristKeys::forBoard(boardSizeX, boardSizeY);
+}
+
+void TicTacToe::updateHash(int x, int y, int player) {
+    int cell = (y - 1) * boardSizeX + (x - 1);
+    for (int t = 0; t < zobrist->symmetryCount(); ++t) {
+        boardHashes[t] ^= zobrist->key(t, cell, player);
+    }
+}
+
+int TicTacToe::canonicalSymmetry() const {
+    int best = 0;
+    for (int t = 1; t < zobrist->symmetryCount(); ++t) {
+        if (boardHashes[t] < boardHashes[best]) best = t;
+    }
+    return best;
+}
+
+unsigned long long TicTacToe::canonicalHash() const {
+    return boardHashes[canonicalSymmetry()];
+}
+
+std::pair<int, int> TicTacToe::getBestMove(int maxDepth, bool isMaximizing) {
+    SearchLimits limits;
+    limits.maxDepth = calculateDepth(maxDepth);
+    return getBestMove(limits, isMaximizing);
+}
+
+std::pair<int, int> TicTacToe::getBestMove(const SearchLimits& limits, bool isMaximizing) {
+    auto start = std::chrono::steady_clock::now();
+    resetNodeCounter();
+    int player = isMaximizing ? 2 : 1;
+    int opponent = 3 - player;
+
+    if (verbose) std::cout << "Maximum depth: " + std::to_string(limits.maxDepth) + '\n';
+
+    std::pair<int, int> knownMove;
+    if (probeTablebase(player, knownMove)) return finishSearch(knownMove, "Tablebase", start);
+    if (probeOpeningBook(player, knownMove)) return finishSearch(knownMove, "Opening book", start);
+
+    if (!transpositionTable) {
+        transpositionTable = std::make_shared<TranspositionTable>(hashSizeMB);
+    }
+    transpositionTable->newSearch();
+    resetMoveOrdering();
+    reserveSearchScratch(limits.maxDepth);
+
+    SearchControl control;
+    control.deadline = limits.deadline;
+    control.maxNodes = limits.maxNodes;
+    searchControl = &control;
+    nodeAllowance = totalNodes;
+
+    // Root moves are generated and statically ordered once; later iterations
+    // only move the previous best to the front. The ordering already counts
+    // against the limits, since scoring every root move is not free on big boards.
+    // The search starts its plies at 1, so the root has the arena's first slice.
+    MoveList moves = plyMoveList(0);
+    generateUniqueMoves(moves);
+    if (moves.empty()) {
+        searchControl = nullptr;
+        return finishSearch({ -1, -1 }, "No moves", start);
+    }
+    orderRootMoves(player, moves);
+
+    for (const auto& move : moves) {
+        if (isWinningMove(move.cell % boardSizeX + 1, move.cell / boardSizeX + 1, player)) {
+            searchControl = nullptr;
+            return finishSearch({ move.cell % boardSizeX + 1, move.cell / boardSizeX + 1 }, "Immediate win", start);
+        }
+    }
+    for (const auto& move : moves) {
+        if (isWinningMove(move.cell % boardSizeX + 1, move.cell / boardSizeX + 1, opponent)) {
+            searchControl = nullptr;
+            return finishSearch({ move.cell % boardSizeX + 1, move.cell / boardSizeX + 1 }, "Forced move", start);
+        }
+    }
+
+    // Long lines leave room for wins built from consecutive threats, which the
+    // forcing-only solver finds far cheaper than the full-width search. It gets a
+    // quarter of the time and node budget; if that runs out the full search goes ahead.
+    unsigned long long threatNodes = limits.maxNodes > totalNodes ? (limits.maxNodes - totalNodes) / 4 : 0;
+    if (matchLength >= 4 && threatSearchDepth > 0 && !control.stopped && (!limits.maxNodes || threatNodes > 0)) {
+        SearchControl threatControl;
+        threatControl.deadline = limits.deadline == std::chrono::steady_clock::time_point::max()
+            ? limits.deadline : start + (limits.deadline - start) / 4;
+        threatControl.maxNodes = limits.maxNodes ? totalNodes + threatNodes : 0;
+        threatControl.nodes = totalNodes;
+        searchControl = &threatControl;
+        nodeAllowance = totalNodes;
+        auto sequence = findThreatSequence(isMaximizing, threatSearchDepth);
+        searchControl = nullptr;
+        if (!sequence.empty()) {
+            return finishSearch(sequence.front(), "Threat sequence of " + std::to_string(sequence.size()) + " moves", start);
+        }
+    }
+
+    // Blocks handed out but not searched are given back: from here on the budget
+    // is charged with the nodes actually visited by the ordering and the threat search
+    control.nodes = totalNodes;
+    searchControl = &control;
+    nodeAllowance = totalNodes;
+
+    // Each helper thread searches on its own copy of the board, all sharing one transposition
+    // table. The copies outlive the search; assigning the position into them reuses their buffers
+    std::vector<TicTacToe>& workers = searchWorkers.engines;
+    size_t workerCount = searchThreads > 1 ? static_cast<size_t>(searchThreads) : 0;
+    if (workers.size() > workerCount) workers.erase(workers.begin() + workerCount, workers.end());
+    for (auto& worker : workers) worker = *this;
+    while (workers.size() < workerCount) workers.push_back(*this);
+
+    std::pair<int, int> bestMove = { moves[0].cell % boardSizeX + 1, moves[0].cell / boardSizeX + 1 };
+    int bestScore = 0;
+
+    for (int currentDepth = 1; currentDepth <= limits.maxDepth; ++currentDepth) {
+        // Aspiration window around the previous iteration's score, widened on a fail
+        int delta = ASPIRATION_WINDOW;
+        int alpha = currentDepth > 1 ? bestScore - delta : -SEARCH_INF;
+        int beta = currentDepth > 1 ? bestScore + delta : SEARCH_INF;
+        std::pair<int, int> result;
+
+        while (true) {
+            result = searchRoot(moves, currentDepth, player, alpha, beta, workers);
+            if (control.stopped) break;
+
+            delta *= 4;
+            if (result.second <= alpha && alpha > -SEARCH_INF) {
+                alpha = delta > MAX_ASPIRATION_WINDOW ? -SEARCH_INF : bestScore - delta;
             }
+            else if (result.second >= beta && beta < SEARCH_INF) {
+                beta = delta > MAX_ASPIRATION_WINDOW ? SEARCH_INF : bestScore + delta;
+            }
+            else {
+                break;
+            }
+        }
+
+        // An interrupted iteration is thrown away; the last completed depth stands
+        if (control.stopped || result.first < 0) break;
+
+        bestMove = { moves[result.first].cell % boardSizeX + 1, moves[result.first].cell / boardSizeX + 1 };
+        bestScore = result.second;
+        std::rotate(moves.begin(), moves.begin() + result.first, moves.begin() + result.first + 1);
+
+        SearchStats::Iteration iteration;
+        iteration.depth = currentDepth;
+        iteration.bestMove = bestMove;
+        iteration.score = bestScore;
+        iteration.nodes = totalNodes;
+        iteration.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.iterations.push_back(iteration);
+        if (infoCallback) infoCallback(iteration);
+        if (verbose) {
+            std::cout << "Depth: " << currentDepth << ", Best move: ("
+                << bestMove.first << ", " << bestMove.second << "), Position score: "
+                << bestScore << ", Time elapsed: " << iteration.seconds << ", Nodes: " << totalNodes << '\n';
         }
+
+        if (std::chrono::steady_clock::now() >= limits.deadline) break;
     }
+
+    searchControl = nullptr;
+    return finishSearch(bestMove, "Search", start);
 }
 
-std::string TicTacToe::hashBoard(const std::vector<std::vector<int>>& boardCopy) const {
-    std::string hash;
-    for (const auto& row : boardCopy) {
-        for (int cell : row) {
-            hash += std::to_string(cell);
-        }
+std::pair<int, int> TicTacToe::finishSearch(const std::pair<int, int>& move, const std::string& reason,
+    std::chrono::steady_clock::time_point start) {
+    stats.nodes = totalNodes;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.reason = reason;
+    if (verbose) {
+        std::cout << "Best move: (" + std::to_string(move.first) + ", " + std::to_string(move.second) + "), reason: " + reason + '\n';
     }
-    return hash;
+    return move;
 }
 
-std::vector<std::vector<int>> TicTacToe::rotateBoard90(const std::vector<std::vector<int>>& boardCopy) const {
-    int N = static_cast<int>(boardCopy.size());
-    std::vector<std::vector<int>> rotatedBoard(N, std::vector<int>(N, 0));
+std::pair<int, int> TicTacToe::searchRoot(const MoveList& moves, int depth,
+    int player, int alpha, int beta, std::vector<TicTacToe>& workers) {
+    int opponent = 3 - player;
+    std::atomic<int> next(0);
+    std::atomic<int> sharedAlpha(alpha);
+    std::mutex bestMutex;
+    int bestIndex = -1;
+    int bestScore = -SEARCH_INF;
+
+    // Root splitting: the threads pull root moves off a shared counter and search
+    // each one against the best bound found so far by any of them. The first move
+    // gets the full window, the rest a null window that is only widened on a fail high.
+    auto searchMoves = [&](TicTacToe& engine) {
+        for (int i = next++; i < moves.size(); i = next++) {
+            int a = sharedAlpha.load();
+            if (a >= beta) break;
+
+            int x = moves[i].cell % boardSizeX + 1, y = moves[i].cell / boardSizeX + 1;
+            engine.makeMove(x, y, player);
+            int score;
+            if (i == 0) {
+                score = -engine.negamax(depth - 1, 1, -beta, -a, opponent);
+            }
+            else {
+                score = -engine.negamax(depth - 1, 1, -a - 1, -a, opponent);
+                if (score > a && score < beta && !engine.searchControl->stopped) {
+                    score = -engine.negamax(depth - 1, 1, -beta, -a, opponent);
+                }
+            }
+            engine.undoMove(x, y);
+            if (engine.searchControl->stopped) break;
 
-    for (int y = 0; y < N; ++y) {
-        for (int x = 0; x < N; ++x) {
-            rotatedBoard[x][N - y - 1] = boardCopy[y][x];
+            std::lock_guard<std::mutex> lock(bestMutex);
+            if (bestIndex < 0 || score > bestScore) {
+                bestIndex = i;
+                bestScore = score;
+                sharedAlpha = std::max(sharedAlpha.load(), score);
+            }
         }
+        // Whatever is left of this thread's block would otherwise go unused by every thread
+        engine.releaseSearchNodes();
+    };
+
+    if (workers.empty()) {
+        searchMoves(*this);
+        return { bestIndex, bestScore };
+    }
+
+    std::vector<std::future<SearchStats>> results;
+    for (auto& worker : workers) {
+        results.push_back(std::async(std::launch::async, [&worker, &searchMoves]() {
+            worker.resetNodeCounter();
+            searchMoves(worker);
+            worker.stats.nodes = worker.totalNodes;
+            return worker.stats;
+        }));
+    }
+    for (auto& result : results) {
+        SearchStats workerStats = result.get();
+        totalNodes += workerStats.nodes;
+        stats.addCounters(workerStats);
     }
 
-    return rotatedBoard;
+    return { bestIndex, bestScore };
 }
 
-std::vector<std::vector<int>> TicTacToe::reflectBoardHorizontal(const std::vector<std::vector<int>>& boardCopy) const {
-    int N = static_cast<int>(boardCopy.size());
-    std::vector<std::vector<int>> reflectedBoard = boardCopy;
+void TicTacToe::pollSearchLimits() {
+    // Nodes are handed out in blocks that never reach past maxNodes, so the threads
+    // together cannot search more than the limit
+    SearchControl& control = *searchControl;
+    unsigned long long block = SEARCH_POLL_INTERVAL;
+    if (control.maxNodes) {
+        unsigned long long used = control.nodes.load();
+        do {
+            if (used >= control.maxNodes) {
+                control.stopped = true;
+                return;
+            }
+            block = std::min(SEARCH_POLL_INTERVAL, control.maxNodes - used);
+        } while (!control.nodes.compare_exchange_weak(used, used + block));
+    }
+    else {
+        control.nodes += block;
+    }
+    nodeAllowance = totalNodes + block;
+    if (std::chrono::steady_clock::now() >= control.deadline) control.stopped = true;
+}
+
+bool TicTacToe::countSearchNode() {
+    if (searchControl) {
+        if (totalNodes >= nodeAllowance) pollSearchLimits();
+        if (searchControl->stopped) return false;
+    }
+    totalNodes++;
+    return true;
+}
 
-    for (int y = 0; y < N; ++y) {
-        reflectedBoard[N - y - 1] = boardCopy[y];
+void TicTacToe::releaseSearchNodes() {
+    if (searchControl && nodeAllowance > totalNodes) {
+        searchControl->nodes -= nodeAllowance - totalNodes;
+        nodeAllowance = totalNodes;
     }
+}
 
-    return reflectedBoard;
+bool TicTacToe::searchDeadlinePassed() {
+    if (!searchControl) return false;
+    if (std::chrono::steady_clock::now() >= searchControl->deadline) searchControl->stopped = true;
+    return searchControl->stopped;
 }
 
-std::string TicTacToe::normalizeBoard() const {
-    std::vector<std::string> symmetries;
+void TicTacToe::orderRootMoves(int player, MoveList& moves) {
+    for (auto& move : moves) {
+        bool scored = !searchDeadlinePassed() && countSearchNode();
+        move.score = scored ? scoreMove({ move.cell % boardSizeX + 1, move.cell / boardSizeX + 1 }, player)
+            : std::numeric_limits<int>::min();
+    }
+    moves.sortByScore();
+}
 
-    auto currentBoard = board;
-    symmetries.push_back(hashBoard(currentBoard));
+void TicTacToe::setVerbose(bool enabled) {
+    verbose = enabled;
+}
 
-    auto rotated = currentBoard;
+void TicTacToe::setSearchInfoCallback(SearchInfoCallback callback) {
+    infoCallback = std::move(callback);
+}
 
-    for (int i = 0; i < 3; ++i) {
-        rotated = rotateBoard90(rotated);
-        symmetries.push_back(hashBoard(rotated));
+void TicTacToe::setSearchThreads(int threads) {
+    if (threads <= 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
     }
+    searchThreads = std::max(1, threads);
+}
 
-    auto reflected = reflectBoardHorizontal(currentBoard);
-    symmetries.push_back(hashBoard(reflected));
+int TicTacToe::getSearchThreads() const {
+    return searchThreads;
+}
 
-    rotated = reflected;
-    for (int i = 0; i < 3; ++i) {
-        rotated = rotateBoard90(rotated);
-        symmetries.push_back(hashBoard(rotated));
+void TicTacToe::setHashSize(size_t megabytes) {
+    hashSizeMB = std::max<size_t>(1, megabytes);
+    if (transpositionTable) {
+        transpositionTable->resize(hashSizeMB);
     }
+}
 
-    return *std::min_element(symmetries.begin(), symmetries.end());
+void TicTacToe::setCandidateRadius(int radius) {
+    candidateRadius = std::max(0, radius);
+    rebuildCandidates();
 }
 
-void TicTacToe::updateHash(int x, int y, int player) {
-    boardHash ^= zobristTable[x - 1][y - 1][player];
+void TicTacToe::clearHash() {
+    if (transpositionTable) {
+        transpositionTable->clear();
+    }
 }
 
-std::pair<int, int> TicTacToe::getBestMove(int maxDepth, bool isMaximizing) {
-    resetNodeCounter();
-    std::pair<int, int> bestMove = { -1, -1 };
-    int bestScore = isMaximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
-    int player = isMaximizing ? 2 : 1;
-    int opponent = 3 - player;
+bool TicTacToe::loadTablebase(const std::string& path, std::string* error) {
+    auto table = std::make_shared<Tablebase>();
+    if (!table->load(path, error)) return false;
+    if (!table->matches(boardSizeX, boardSizeY, matchLength)) {
+        if (error) *error = "Tablebase " + path + " is for a different board";
+        return false;
+    }
+    tablebase = table;
+    return true;
+}
 
-    int dDepth = calculateDepth(maxDepth);
-    std::cout << "Maximum depth: " + std::to_string(dDepth) + '\n';
+bool TicTacToe::probeTablebase(int player, std::pair<int, int>& bestMove) const {
+    // The table only knows the side to move that the stone counts imply
+    if (!tablebase || player != (stoneCount % 2 == 0 ? 2 : 1)) return false;
 
-    time_t tick1 = clock();
+    uint64_t index = 0;
+    for (int cell = 0; cell < boardSizeX * boardSizeY; ++cell) {
+        index += cellAt(cell % boardSizeX, cell / boardSizeX) * Tablebase::cellWeight(cell);
+    }
 
-    for (int currentDepth = 1; currentDepth <= dDepth; ++currentDepth) {
-        auto moves = getOrderedMoves(player);
-        for (const auto& move : moves) {
-            makeMove(move.first, move.second, player);
+    // Children are stored from the opponent's side: its loss is our win
+    int bestRank = -1;
+    for (int cell = 0; cell < boardSizeX * boardSizeY; ++cell) {
+        if (cellAt(cell % boardSizeX, cell / boardSizeX) != 0) continue;
+        uint8_t entry = tablebase->probe(index + player * Tablebase::cellWeight(cell));
+        int distance = Tablebase::distanceOf(entry);
+        int rank;
+        switch (Tablebase::valueOf(entry)) {
+        case Tablebase::LOSS: rank = 3 * 64 - distance; break;  // fastest win
+        case Tablebase::DRAW: rank = 2 * 64; break;
+        case Tablebase::WIN: rank = 64 + distance; break;  // slowest loss
+        default: return false;
+        }
+        if (rank > bestRank) {
+            bestRank = rank;
+            bestMove = { cell % boardSizeX + 1, cell / boardSizeX + 1 };
+        }
+    }
+    return bestRank >= 0;
+}
 
-            if (checkLines(player) || checkDiagonals(player)) {
-                undoMove(move.first, move.second);
-                std::cout << "Best move: (" + std::to_string(move.first) + ", " + std::to_string(move.second) + "), reason: Immediate win\n";
-                return move;
-            }
-            makeMove(move.first, move.second, opponent);
-            if (checkLines(opponent) || checkDiagonals(opponent)) {
-                undoMove(move.first, move.second);
-                undoMove(move.first, move.second);
-                std::cout << "Best move: (" + std::to_string(move.first) + ", " + std::to_string(move.second) + "), reason: Forced move\n";
-                return move;
-            }
-            undoMove(move.first, move.second);
+bool TicTacToe::loadOpeningBook(const std::string& path, std::string* error) {
+    auto book = std::make_shared<OpeningBook>();
+    if (!book->load(path, error)) return false;
+    if (!book->matches(boardSizeX, boardSizeY, matchLength)) {
+        if (error) *error = "Opening book " + path + " is for a different board";
+        return false;
+    }
+    openingBook = book;
+    return true;
+}
+
+void TicTacToe::setBookSeed(uint64_t seed) {
+    // xorshift never leaves the all-zero state, so that one seed is swapped for the default
+    bookRandomState = seed ? seed : DEFAULT_BOOK_SEED;
+}
 
-            int score = minimax(currentDepth - 1, !isMaximizing,
-                std::numeric_limits<int>::min(),
-                std::numeric_limits<int>::max());
-            undoMove(move.first, move.second);
+uint32_t TicTacToe::nextBookRandom(uint32_t bound) {
+    bookRandomState ^= bookRandomState >> 12;
+    bookRandomState ^= bookRandomState << 25;
+    bookRandomState ^= bookRandomState >> 27;
+    uint64_t value = (bookRandomState * 0x2545F4914F6CDD1DULL) >> 32;
+    return static_cast<uint32_t>((value * bound) >> 32);
+}
 
-            printDebugInfo(currentDepth, moves, player);
-            // std::cout << "Move: (" + std::to_string(move.first) + ", " + std::to_string(move.second) + "), Position score: " + std::to_string(score) + '\n';
+bool TicTacToe::probeOpeningBook(int player, std::pair<int, int>& bestMove) {
+    if (!openingBook || player != (stoneCount % 2 == 0 ? 2 : 1)) return false;
 
-            if ((isMaximizing && score > bestScore) || (!isMaximizing && score < bestScore)) {
-                bestScore = score;
-                bestMove = move;
-            }
+    int symmetry = canonicalSymmetry();
+    auto range = openingBook->probe(boardHashes[symmetry]);
+    uint32_t total = 0;
+    for (auto entry = range.first; entry != range.second; ++entry) {
+        total += entry->weight;
+    }
+    if (total == 0) return false;
+
+    uint32_t pick = nextBookRandom(total);
+    for (auto entry = range.first; entry != range.second; ++entry) {
+        if (pick < entry->weight) {
+            int cell = entry->move < boardSizeX * boardSizeY ? zobrist->unmapCell(symmetry, entry->move) : -1;
+            // A hash collision could name an occupied cell; fall back to searching
+            if (cell < 0 || cellAt(cell % boardSizeX, cell / boardSizeX) != 0) return false;
+            bestMove = { cell % boardSizeX + 1, cell / boardSizeX + 1 };
+            return true;
         }
+        pick -= entry->weight;
+    }
+    return false;
+}
 
-        time_t tick2 = clock();
-        if (bestMove != std::make_pair(-1, -1))
-            std::cout << "Depth: " << currentDepth << ", Best move: ("
-                << bestMove.first << ", " << bestMove.second << "), Position score: "
-                << bestScore << ", " << " Move score: " + std::to_string(scoreMove(bestMove, player)) + ", " <<
-                "Time elasped : " + std::to_string(static_cast<double>(tick2 - tick1) / 1000.0) + '\n';
+void TicTacToe::addBookMove(OpeningBookBuilder& book, std::pair<int, int> move, uint32_t weight) const {
+    int symmetry = canonicalSymmetry();
+    int cell = (move.second - 1) * boardSizeX + (move.first - 1);
+    book.add(boardHashes[symmetry], zobrist->mapCell(symmetry, cell), weight);
+}
+
+void TicTacToe::addBookGame(OpeningBookBuilder& book, const std::vector<std::pair<int, int>>& moves, int maxPlies) {
+    size_t played = 0;
+    for (const auto& move : moves) {
+        if (static_cast<int>(played) >= maxPlies || isTerminal()) break;
+        if (move.first < 1 || move.first > boardSizeX || move.second < 1 || move.second > boardSizeY
+            || cellAt(move.first - 1, move.second - 1) != 0) break;
+        addBookMove(book, move);
+        makeMove(move.first, move.second, stoneCount % 2 == 0 ? 2 : 1);
+        ++played;
+    }
+    while (played > 0) {
+        const auto& move = moves[--played];
+        undoMove(move.first, move.second);
+    }
+}
+
+void TicTacToe::searchBookMoves(OpeningBookBuilder& book, int plies, int depth) {
+    if (plies <= 0 || isTerminal()) return;
+    int player = stoneCount % 2 == 0 ? 2 : 1;
+
+    if (!book.contains(canonicalHash())) {
+        SearchLimits limits;
+        limits.maxDepth = depth;
+        auto best = getBestMove(limits, player == 2);
+        if (best.first < 0) return;
+        addBookMove(book, best);
     }
 
-    return bestMove;
+    for (const auto& move : getSymmetryUniqueMoves()) {
+        makeMove(move.first, move.second, player);
+        searchBookMoves(book, plies - 1, depth);
+        undoMove(move.first, move.second);
+    }
 }
 
 bool TicTacToe::isLineBlocked(int x, int y, int player) {
     int opponent = (player == 1) ? 2 : 1;
-    std::vector<std::pair<int, int>> directions = {
-        {0, 1}, {1, 0}, {1, 1}, {1, -1}
-    };
+    static const int directions[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
 
     for (const auto& dir : directions) {
-        int dx = dir.first, dy = dir.second;
+        int dx = dir[0], dy = dir[1];
         int countPlayer = 0, countEmpty = 0, countOpponent = 0;
 
         for (int step = -matchLength + 1; step < matchLength; ++step) {
@@ -150,9 +483,10 @@ bool TicTacToe::isLineBlocked(int x, int y, int player) {
 
             if (nx < 0 || ny < 0 || nx >= boardSizeX || ny >= boardSizeY) continue;
 
-            if (board[ny][nx] == player) countPlayer++;
-            else if (board[ny][nx] == 0) countEmpty++;
-            else if (board[ny][nx] == opponent) countOpponent++;
+            int cell = cellAt(nx, ny);
+            if (cell == player) countPlayer++;
+            else if (cell == 0) countEmpty++;
+            else if (cell == opponent) countOpponent++;
         }
 
         // If the line is blocked on both sides, it's a blocked opportunity
@@ -171,21 +505,14 @@ int TicTacToe::scoreMove(const std::pair<int, int>& move, int player) {
     int opponent = 3 - player;
     int score = 0;
 
-    makeMove(move.first, move.second, player);
-
-    if (checkLines(player) || checkDiagonals(player)) {
-        undoMove(move.first, move.second);
+    if (isWinningMove(move.first, move.second, player)) {
         return 4000;  // Winning move
     }
 
     // Check for blocking opponent's winning move
-    makeMove(move.first, move.second, opponent);
-    if (checkLines(opponent) || checkDiagonals(opponent)) {
-        undoMove(move.first, move.second);
-        undoMove(move.first, move.second);
+    if (isWinningMove(move.first, move.second, opponent)) {
         return 3750;  // Defensive (opponent blocking) move
     }
-    undoMove(move.first, move.second);
     makeMove(move.first, move.second, player);
 
     int maxPoint = 1000;
@@ -239,23 +566,14 @@ int TicTacToe::scoreMove(const std::pair<int, int>& move, int player) {
     return std::min(score, 3749);
 }
 
-std::vector<std::pair<std::pair<int, int>, int>> TicTacToe::getScoredMoves(int player, std::pair<int, int> prioritizedMove) {
-    std::vector<std::pair<std::pair<int, int>, int>> scoredMoves;
-
-    for (int y = 0; y < boardSizeY; ++y) {
-        for (int x = 0; x < boardSizeX; ++x) {
-            if (board[y][x] == 0) {
-                std::pair<int, int> move = { x + 1, y + 1 };
-                int score = (move == prioritizedMove) ? 1000 : scoreMove(move, player);
-                scoredMoves.emplace_back(move, score);
-            }
-        }
+void TicTacToe::getScoredMoves(MoveList& moves, int player, int prioritizedCell) {
+    generateMoves(moves);
+    for (auto& move : moves) {
+        // The prioritized (transposition table) move goes ahead of even a winning move
+        move.score = (move.cell == prioritizedCell) ? 5000
+            : scoreMove({ move.cell % boardSizeX + 1, move.cell / boardSizeX + 1 }, player);
     }
-
-    std::sort(scoredMoves.begin(), scoredMoves.end(),
-        [](const auto& a, const auto& b) { return a.second > b.second; });
-
-    return scoredMoves;
+    moves.sortByScore();
 }
 
 bool TicTacToe::isStrandedPiece(const std::pair<int, int>& move, int player) {
@@ -276,7 +594,7 @@ bool TicTacToe::isStrandedPiece(const std::pair<int, int>& move, int player) {
                 if (dx == 0 && dy == 0) continue;  // Skip the move itself
                 int nx = x + dx, ny = y + dy;
                 if (nx >= 0 && ny >= 0 && nx < boardSizeX && ny < boardSizeY) {
-                    if (board[ny][nx] == player) surroundingCount++;
+                    if (cellAt(nx, ny) == player) surroundingCount++;
                 }
             }
         }
@@ -289,76 +607,43 @@ bool TicTacToe::isStrandedPiece(const std::pair<int, int>& move, int player) {
 }
 
 bool TicTacToe::isImmediateThreat(const std::pair<int, int>& move, int opponent) {
-    makeMove(move.first, move.second, opponent);
-    bool immediateThreat = checkLines(opponent) || checkDiagonals(opponent);
-    undoMove(move.first, move.second);
-    return immediateThreat;
+    return isWinningMove(move.first, move.second, opponent);
 }
 
 int TicTacToe::countLines(int player, int length) const {
-    static const std::vector<std::pair<int, int>> directions = {
-        {1, 0}, {0, 1}, {1, 1}, {1, -1}
-    };
+    if (length <= 0) return 0;
 
+    const Bitboard& own = stones[player - 1];
     int count = 0;
-
-    if (length == 0) return 0;
-
-    for (int y = 0; y < boardSizeY; ++y) {
-        for (int x = 0; x < boardSizeX; ++x) {
-            if (board[y][x] != player) continue;
-
-            for (const auto& p : directions) {
-                int dx = p.first;
-                int dy = p.second;
-                bool valid = true;
-                for (int k = 1; k < length; ++k) {
-                    int nx = x + k * dx;
-                    int ny = y + k * dy;
-                    if (nx < 0 || ny < 0 || nx >= boardSizeX || ny >= boardSizeY || board[ny][nx] != player) {
-                        valid = false;
-                        break;
-                    }
-                }
-                if (valid) count++;
-            }
-        }
+    for (int step : lineSteps) {
+        count += own.countRuns(step, length);
     }
 
     return count;
 }
 
 std::vector<std::pair<int, int>> TicTacToe::getOrderedMoves(int player) {
-    auto moves = getAvailableMoves();
-    std::vector<std::pair<std::pair<int, int>, int>> scoredMoves;
+    return getOrderedMoves(player, getAvailableMoves());
+}
 
+std::vector<std::pair<int, int>> TicTacToe::getOrderedMoves(int player, const std::vector<std::pair<int, int>>& moves) {
     // Evaluate and score each move
+    std::vector<ScoredMove> scoredMoves(moves.size());
+    MoveList list(scoredMoves.data(), static_cast<int>(scoredMoves.size()));
     for (const auto& move : moves) {
-        int score = scoreMove(move, player);
-        scoredMoves.emplace_back(move, score);
+        list.add((move.second - 1) * boardSizeX + (move.first - 1), scoreMove(move, player));
     }
-    std::sort(scoredMoves.begin(), scoredMoves.end(), [](const auto& a, const auto& b) {
-        return a.second > b.second;
-    });
+    list.sortByScore();
 
     std::vector<std::pair<int, int>> orderedMoves;
-    for (const auto& scoredMove : scoredMoves) {
-        orderedMoves.push_back(scoredMove.first);
+    orderedMoves.reserve(moves.size());
+    for (const auto& scoredMove : list) {
+        orderedMoves.emplace_back(scoredMove.cell % boardSizeX + 1, scoredMove.cell / boardSizeX + 1);
     }
 
     return orderedMoves;
 }
 
-void TicTacToe::printDebugInfo(int depth, const std::vector<std::pair<int, int>>& moves, int player) {
-    std::cout << "\nDepth " + std::to_string(depth) + " analyzation:" << "\n";
-    std::cout << "Player: " << player << "\n";
-
-    for (const auto& move : moves) {
-        int score = scoreMove(move, player);
-        std::cout << "Move: (" << move.first << ", " << move.second << ") Score: " << score << '\n';
-    }
-}
-
 int TicTacToe::calculateDepth(int maxDepth) {
     int baseDepth = 3;
 
@@ -386,6 +671,12 @@ int TicTacToe::calculateDepth(int maxDepth) {
 void TicTacToe::resetNodeCounter() {
     currentNode = 0;
     totalNodes = 0;
+    nodeAllowance = 0;
+    // The iteration list keeps its buffer, so later searches no deeper than this one do not allocate
+    std::vector<SearchStats::Iteration> iterations = std::move(stats.iterations);
+    iterations.clear();
+    stats = SearchStats();
+    stats.iterations = std::move(iterations);
 }
 
 void TicTacToe::printCurrentLine(int score) const {
@@ -404,210 +695,380 @@ void TicTacToe::printCurrentLine(int score) const {
 }
 
 int TicTacToe::countPotentialWinningLines(int player) {
+    // Windows with no opponent stone and at least one empty cell, kept up to date by makeMove/undoMove
+    return potentialWindows[player - 1];
+}
+
+// Helper function to evaluate position
+int TicTacToe::evaluatePosition(bool isMaximizing) {
+    int player = isMaximizing ? 2 : 1;
     int opponent = 3 - player;
-    int potentialLines = 0;
-
-    // Check rows
-    for (int i = 0; i < boardSizeY; ++i) {
-        for (int j = 0; j <= boardSizeX - matchLength; ++j) {
-            std::vector<std::pair<int, int>> line;
-            for (int k = 0; k < matchLength; ++k) {
-                line.emplace_back(i, j + k);
-            }
-            if (isPotentialWinningLine(line, player)) {
-                potentialLines++;
-            }
-        }
-    }
 
-    // Check columns
-    for (int j = 0; j < boardSizeY; ++j) {
-        for (int i = 0; i <= boardSizeX - matchLength; ++i) {
-            std::vector<std::pair<int, int>> line;
-            for (int k = 0; k < matchLength; ++k) {
-                line.emplace_back(i + k, j);
-            }
-            if (isPotentialWinningLine(line, player)) {
-                potentialLines++;
-            }
-        }
+    // Winning positions
+    if (winnerPlayer == player) return WIN_SCORE;
+    if (winnerPlayer == opponent) return -WIN_SCORE;
+
+    int score = 0;
+
+    // Add scores for potential lines
+    score += countPotentialWinningLines(player) * 50;  // Emphasize potential winning lines for the player
+    score -= countPotentialWinningLines(opponent) * 50;  // Penalize opponent's potential lines
+
+    // Add scores for nearly complete lines, counted as open windows one or two stones short
+    const std::vector<int>& own = openWindows[player - 1];
+    const std::vector<int>& other = openWindows[opponent - 1];
+    score -= other[matchLength - 1] * 1000 / (matchLength * 2);  // Opponent nearly winning
+    score += own[matchLength - 1] * 1000 / (matchLength * 2);   // Player nearly winning
+
+    score -= other[matchLength - 2] * 400 / (matchLength * 2);  // Opponent strong position
+    score += own[matchLength - 2] * 400 / (matchLength * 2);    // Player strong position
+
+    return score;
+}
+
+std::vector<std::pair<int, int>> TicTacToe::getAvailableMoves() {
+    std::vector<ScoredMove> buffer(boardSizeX * boardSizeY);
+    MoveList cells(buffer.data(), static_cast<int>(buffer.size()));
+    generateMoves(cells);
+
+    std::vector<std::pair<int, int>> moves;
+    moves.reserve(cells.size());
+    for (const auto& move : cells) {
+        moves.emplace_back(move.cell % boardSizeX + 1, move.cell / boardSizeX + 1);
     }
+    return moves;
+}
 
-    // Check diagonals (top-left to bottom-right)
-    for (int i = 0; i <= boardSizeY - matchLength; ++i) {
-        for (int j = 0; j <= boardSizeX - matchLength; ++j) {
-            std::vector<std::pair<int, int>> line;
-            for (int k = 0; k < matchLength; ++k) {
-                line.emplace_back(i + k, j + k);
-            }
-            if (isPotentialWinningLine(line, player)) {
-                potentialLines++;
-            }
+void TicTacToe::generateMoves(MoveList& moves) const {
+    moves.clear();
+
+    // Only cells near existing stones are worth searching; the empty board
+    // (or a position with no empty cell in reach) falls back to every cell
+    if (candidateRadius > 0 && !candidateCells.empty()) {
+        for (int cell : candidateCells) {
+            moves.add(cell);
         }
+        return;
     }
 
-    // Check diagonals (top-right to bottom-left)
-    for (int i = 0; i <= boardSizeY - matchLength; ++i) {
-        for (int j = matchLength - 1; j < boardSizeX; ++j) {
-            std::vector<std::pair<int, int>> line;
-            for (int k = 0; k < matchLength; ++k) {
-                line.emplace_back(i + k, j - k);
-            }
-            if (isPotentialWinningLine(line, player)) {
-                potentialLines++;
+    for (int y = 0; y < boardSizeY; ++y) {
+        for (int x = 0; x < boardSizeX; ++x) {
+            if (cellAt(x, y) == 0) {
+                moves.add(y * boardSizeX + x);
             }
         }
     }
-
-    return potentialLines;
 }
 
+int TicTacToe::getPositionSymmetries(int* symmetries) const {
+    int count = 0;
+    int cells = boardSizeX * boardSizeY;
 
-bool TicTacToe::isPotentialWinningLine(const std::vector<std::pair<int, int>>& line, int player) {
-    int opponent = 3 - player;
-    bool hasEmptyCell = false;
-
-    for (const auto& cell : line) {
-        int row = cell.first;
-        int col = cell.second;
+    for (int t = 1; t < zobrist->symmetryCount(); ++t) {
+        if (boardHashes[t] != boardHashes[0]) continue;
 
-        if (board[row][col] == opponent) {
-            return false;  // Line is blocked by the opponent
+        // Equal hashes almost always mean a real symmetry, but confirm it cell by cell
+        bool symmetric = true;
+        for (int c = 0; c < cells && symmetric; ++c) {
+            int mapped = zobrist->mapCell(t, c);
+            symmetric = cellAt(c % boardSizeX, c / boardSizeX) == cellAt(mapped % boardSizeX, mapped / boardSizeX);
         }
+        if (symmetric) symmetries[count++] = t;
+    }
+    return count;
+}
 
-        // Check if the cell is empty
-        if (board[row][col] == 0) {
-            hasEmptyCell = true;
+void TicTacToe::generateUniqueMoves(MoveList& moves) const {
+    generateMoves(moves);
+    int symmetries[ZobristKeys::MAX_SYMMETRIES];
+    int symmetryCount = getPositionSymmetries(symmetries);
+    if (symmetryCount == 0) return;
+
+    // The symmetries that fix the position form a group, so a move stands for its
+    // whole class exactly when no symmetry maps it to a lower cell
+    int kept = 0;
+    for (int i = 0; i < moves.size(); ++i) {
+        int cell = moves[i].cell;
+        bool representative = true;
+        for (int t = 0; t < symmetryCount && representative; ++t) {
+            representative = zobrist->mapCell(symmetries[t], cell) >= cell;
         }
+        if (representative) moves[kept++] = moves[i];
     }
+    moves.truncate(kept);
+}
 
-    // The line is valid if it contains no opponent pieces and has at least one empty cell
-    return hasEmptyCell;
+std::vector<std::pair<int, int>> TicTacToe::getSymmetryUniqueMoves() {
+    std::vector<ScoredMove> buffer(boardSizeX * boardSizeY);
+    MoveList cells(buffer.data(), static_cast<int>(buffer.size()));
+    generateUniqueMoves(cells);
+
+    std::vector<std::pair<int, int>> moves;
+    moves.reserve(cells.size());
+    for (const auto& move : cells) {
+        moves.emplace_back(move.cell % boardSizeX + 1, move.cell / boardSizeX + 1);
+    }
+    return moves;
 }
 
-// Helper function to evaluate position
-int TicTacToe::evaluatePosition(bool isMaximizing) {
-    int player = isMaximizing ? 2 : 1;
-    int opponent = 3 - player;
+void TicTacToe::resetMoveOrdering() {
+    int cells = boardSizeX * boardSizeY;
+    killerMoves.assign((cells + 1) * 2, -1);
+    historyScores[0].assign(cells, 0);
+    historyScores[1].assign(cells, 0);
+}
 
-    // Winning positions
-    if (checkLines(player) || checkDiagonals(player)) return 1000;
-    if (checkLines(opponent) || checkDiagonals(opponent)) return -1000;
+void TicTacToe::reserveSearchScratch(int maxDepth) {
+    // No line runs deeper than the empty cells left, plus one slice for the root
+    int cells = boardSizeX * boardSizeY;
+    int plies = std::min(maxDepth, cells - stoneCount) + 1;
+    size_t needed = static_cast<size_t>(std::max(plies, 1)) * cells;
+    if (moveArena.size() < needed) moveArena.resize(needed);
+}
 
-    int score = 0;
+MoveList TicTacToe::plyMoveList(int ply) {
+    int cells = boardSizeX * boardSizeY;
+    assert(static_cast<size_t>(ply + 1) * cells <= moveArena.size());
+    return MoveList(&moveArena[static_cast<size_t>(ply) * cells], cells);
+}
 
-    // Add scores for potential lines
-    score += countPotentialWinningLines(player) * 50;  // Emphasize potential winning lines for the player
-    score -= countPotentialWinningLines(opponent) * 50;  // Penalize opponent's potential lines
+void TicTacToe::getSearchMoves(MoveList& moves, int player, int ply, int ttMove) {
+    // Near the root the full static scoring is worth its cost
+    if (ply < STATIC_ORDERING_PLIES) {
+        getScoredMoves(moves, player, ttMove);
+        return;
+    }
 
-    // Add scores for nearly complete lines
-    score -= countLines(opponent, matchLength - 1) * 1000 / (matchLength * 2);  // Opponent nearly winning
-    score += countLines(player, matchLength - 1) * 1000 / (matchLength * 2);   // Player nearly winning
+    // Deeper down: TT move, wins, forced blocks, killers, then history
+    int opponent = 3 - player;
+    const int* killers = &killerMoves[ply * 2];
+    const std::vector<int>& history = historyScores[player - 1];
+
+    generateMoves(moves);
+    for (auto& move : moves) {
+        int cell = move.cell;
+        int x = cell % boardSizeX + 1, y = cell / boardSizeX + 1;
+        if (cell == ttMove) move.score = 1 << 30;
+        else if (isWinningMove(x, y, player)) move.score = 1 << 29;
+        else if (isWinningMove(x, y, opponent)) move.score = 1 << 28;
+        else if (cell == killers[0]) move.score = 1 << 27;
+        else if (cell == killers[1]) move.score = (1 << 27) - 1;
+        else move.score = std::min(history[cell], (1 << 27) - 2);
+    }
+    moves.sortByScore();
+}
 
-    score -= countLines(opponent, matchLength - 2) * 400 / (matchLength * 2);  // Opponent strong position
-    score += countLines(player, matchLength - 2) * 400 / (matchLength * 2);    // Player strong position
+void TicTacToe::recordCutoff(int player, int ply, int cell, int depth) {
+    int* killers = &killerMoves[ply * 2];
+    if (killers[0] != cell) {
+        killers[1] = killers[0];
+        killers[0] = cell;
+    }
+    historyScores[player - 1][cell] += depth * depth;
+}
 
+// Mate scores are stored relative to the node, so the same entry stays valid
+// when the position is reached at a different distance from the root
+static int scoreToTable(int score, int ply) {
+    if (score > TicTacToe::WIN_THRESHOLD) return score + ply;
+    if (score < -TicTacToe::WIN_THRESHOLD) return score - ply;
     return score;
 }
 
-std::vector<std::pair<int, int>> TicTacToe::getAvailableMoves() {
-    std::vector<std::pair<int, int>> moves;
-    for (int y = 0; y < boardSizeY; ++y) {
-        for (int x = 0; x < boardSizeX; ++x) {
-            if (board[y][x] == 0) {
-                moves.emplace_back(x + 1, y + 1);
-            }
-        }
-    }
-    return moves;
+static int scoreFromTable(int score, int ply) {
+    if (score > TicTacToe::WIN_THRESHOLD) return score - ply;
+    if (score < -TicTacToe::WIN_THRESHOLD) return score + ply;
+    return score;
 }
 
-// Minimax function
-int TicTacToe::minimax(int depth, bool isMaximizing, int alpha, int beta) {
-    totalNodes++; // ignore, for debugging
+// Negamax with principal variation search; scores are from the side to move
+int TicTacToe::negamax(int depth, int ply, int alpha, int beta, int player) {
+    if (!countSearchNode()) return 0;
 
-    if (depth == 0 || isGameOver) {
-        return evaluatePosition(isMaximizing);
-    }
+    // The last move made a line, so the side to move has lost; sooner losses score lower
+    if (winnerPlayer != 0) return winnerPlayer == player ? WIN_SCORE - ply : -(WIN_SCORE - ply);
+    if (stoneCount == boardSizeX * boardSizeY) return 0;
+    if (depth <= 0) return evaluatePosition(player == 2);
 
-    unsigned long long currentHash = boardHash;
+    // The table outlives a single search, and the same stones can come up with either
+    // side to move (e.g. getBestMove asked for both sides), so the side is part of the key
+    unsigned long long currentHash = canonicalHash() ^ (player == 1 ? zobrist->sideKey() : 0);
+    int symmetry = canonicalSymmetry();
+    int alphaOrig = alpha;
 
     // transpos-table
-    if (transpositionTable.find(currentHash) != transpositionTable.end()) {
-        const TTEntry& entry = transpositionTable[currentHash];
-        if (entry.depth == depth) {
+    TTEntry entry;
+    int ttMove = -1;
+    stats.ttProbes++;
+    if (transpositionTable->probe(currentHash, entry)) {
+        stats.ttHits++;
+        // The stored move is in the canonical orientation; bring it back to this board
+        if (entry.move >= 0) ttMove = zobrist->unmapCell(symmetry, entry.move);
+        if (entry.depth >= depth) {
+            int score = scoreFromTable(entry.score, ply);
             if (entry.flag == TTEntry::EXACT ||
-                (entry.flag == TTEntry::LOWER && entry.score >= beta) ||
-                (entry.flag == TTEntry::UPPER && entry.score <= alpha)) {
-                return entry.score;
+                (entry.flag == TTEntry::LOWER && score >= beta) ||
+                (entry.flag == TTEntry::UPPER && score <= alpha)) {
+                stats.ttCutoffs++;
+                return score;
             }
         }
     }
 
-    int bestScore = isMaximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
-    int player = isMaximizing ? 2 : 1;
+    int opponent = 3 - player;
+    int bestScore = -SEARCH_INF;
+    int bestCell = -1;
 
-    auto moves = getOrderedMoves(player);
+    // Near the root every move gets the full static score, far more work than a node
+    // deeper down, so these nodes cannot wait for the next block to see the deadline
+    if (ply < STATIC_ORDERING_PLIES && searchDeadlinePassed()) return 0;
+
+    MoveList moves = plyMoveList(ply);
+    getSearchMoves(moves, player, ply, ttMove);
     int moveCount = 0;
 
-    for (const auto& move : moves) {
+    for (const auto& scored : moves) {
+        std::pair<int, int> move = { scored.cell % boardSizeX + 1, scored.cell / boardSizeX + 1 };
         // ignore, for debugging
         currentNode++;
         moveCount++;
 
         makeMove(move.first, move.second, player);
 
-        // LMR
-        int newDepth = depth - 1;
-        if (moveCount > 2 && depth > 2) {
-            newDepth--;
+        int score;
+        if (moveCount == 1) {
+            score = -negamax(depth - 1, ply + 1, -beta, -alpha, opponent);
+        }
+        else {
+            // LMR: late moves get a reduced null-window search first
+            int reduction = (moveCount > 2 && depth > 2) ? 1 : 0;
+            score = -negamax(depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, opponent);
+            if (score > alpha && reduction) {
+                score = -negamax(depth - 1, ply + 1, -alpha - 1, -alpha, opponent);
+            }
+            if (score > alpha && score < beta) {
+                score = -negamax(depth - 1, ply + 1, -beta, -alpha, opponent);
+            }
         }
-
-        int score = minimax(newDepth, !isMaximizing, alpha, beta);
         undoMove(move.first, move.second);
+        if (searchControl && searchControl->stopped) return 0;
 
-        if (isMaximizing) {
-            bestScore = std::max(bestScore, score);
-            alpha = std::max(alpha, bestScore);
-        }
-        else {
-            bestScore = std::min(bestScore, score);
-            beta = std::min(beta, bestScore);
+        if (score > bestScore) {
+            bestScore = score;
+            bestCell = scored.cell;
         }
+        alpha = std::max(alpha, score);
 
-        if (beta <= alpha) break;
+        if (alpha >= beta) {
+            stats.betaCutoffs++;
+            if (moveCount == 1) stats.firstMoveCutoffs++;
+            recordCutoff(player, ply, bestCell, depth);
+            break;
+        }
     }
 
-    TTEntry::BoundType bound = (bestScore <= alpha) ? TTEntry::UPPER
+    TTEntry::BoundType bound = (bestScore <= alphaOrig) ? TTEntry::UPPER
         : (bestScore >= beta) ? TTEntry::LOWER
         : TTEntry::EXACT;
-    transpositionTable[currentHash] = { bestScore, depth, bound };
+    int storedMove = bestCell >= 0 ? zobrist->mapCell(symmetry, bestCell) : -1;
+    transpositionTable->store(currentHash, { scoreToTable(bestScore, ply), depth, bound, storedMove });
 
     return bestScore;
 }
 
+unsigned long long TicTacToe::perft(int depth) {
+    return perftFrom(depth, isXTurn ? 2 : 1);
+}
+
+unsigned long long TicTacToe::perftFrom(int depth, int player) {
+    if (depth <= 0 || isTerminal()) return 1;
+
+    unsigned long long leaves = 0;
+    for (int y = 1; y <= boardSizeY; ++y) {
+        for (int x = 1; x <= boardSizeX; ++x) {
+            if (cellAt(x - 1, y - 1) != 0) continue;
+            if (depth == 1) {
+                ++leaves;
+                continue;
+            }
+            makeMove(x, y, player);
+            leaves += perftFrom(depth - 1, 3 - player);
+            undoMove(x, y);
+        }
+    }
+    return leaves;
+}
+
 void TicTacToe::makeMove(int x, int y, int player) {
-    board[y - 1][x - 1] = player;
+    stones[player - 1].set(stones[0].index(x - 1, y - 1));
     updateHash(x, y, player);
+    // A window full of the player's stones is exactly a line through this cell
+    bool completed = updateWindows((y - 1) * boardSizeX + (x - 1), player, true);
+    updateCandidates((y - 1) * boardSizeX + (x - 1), true);
+    stoneCount++;
+    if (winnerPlayer == 0 && completed) {
+        winnerPlayer = player;
+        winPly = stoneCount;
+    }
 }
 
 void TicTacToe::undoMove(int x, int y) {
-    int player = board[y - 1][x - 1];
-    board[y - 1][x - 1] = 0;
+    int player = cellAt(x - 1, y - 1);
+    if (player == 0) return;
+    stones[player - 1].clear(stones[0].index(x - 1, y - 1));
     updateHash(x, y, player);
+    updateWindows((y - 1) * boardSizeX + (x - 1), player, false);
+    updateCandidates((y - 1) * boardSizeX + (x - 1), false);
+    if (stoneCount == winPly) {
+        winnerPlayer = 0;
+        winPly = -1;
+    }
+    stoneCount--;
+}
+
+bool TicTacToe::isWinningMove(int x, int y, int player) const {
+    if (boardKernels) return boardKernels->isWinningMove(*this, (y - 1) * boardSizeX + (x - 1), player);
+
+    static const int directions[4][2] = { {1, 0}, {0, 1}, {1, 1}, {1, -1} };
+    const Bitboard& own = stones[player - 1];
+    int cx = x - 1, cy = y - 1;
+
+    // Walk out both ways from the cell; the cell itself counts whether or not it is placed yet
+    for (const auto& dir : directions) {
+        int run = 1;
+        for (int sign = -1; sign <= 1; sign += 2) {
+            int nx = cx + sign * dir[0], ny = cy + sign * dir[1];
+            while (run < matchLength && nx >= 0 && ny >= 0 && nx < boardSizeX && ny < boardSizeY
+                && own.test(own.index(nx, ny))) {
+                run++;
+                nx += sign * dir[0];
+                ny += sign * dir[1];
+            }
+        }
+        if (run >= matchLength) return true;
+    }
+    return false;
+}
+
+bool TicTacToe::isTerminal() const {
+    return winnerPlayer != 0 || stoneCount == boardSizeX * boardSizeY;
 }
 
 int TicTacToe::analyzeLastMove() {
     if (previousMoves.empty()) return 0;
-    int result = scoreMove(previousMoves.back(), isXTurn ? 1 : 2);
-    makeMove(previousMoves.back().first, previousMoves.back().second, isXTurn ? 1 : 2);
+    const auto& lastMove = previousMoves.back();
+    int lastPlayer = isXTurn ? 1 : 2;
+    undoMove(lastMove.first, lastMove.second);
+    int result = scoreMove(lastMove, lastPlayer);
+    makeMove(lastMove.first, lastMove.second, lastPlayer);
     return result;
 }
 
 int TicTacToe::countThreatsBlocked(int x, int y, int opponent) {
     int threatsBlocked = 0;
 
-    board[y][x] = opponent;
+    int bit = stones[0].index(x, y);
+    stones[opponent - 1].set(bit);
 
     // Check all directions for threats blocked
     if (checkLines(opponent)) {
@@ -617,7 +1078,7 @@ int TicTacToe::countThreatsBlocked(int x, int y, int opponent) {
         threatsBlocked++;
     }
 
-    board[y][x] = 0;
+    stones[opponent - 1].clear(bit);
 
     return threatsBlocked;
 }
\ No newline at end of file
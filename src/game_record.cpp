@@ -0,0 +1,245 @@
+#include "../include/game_record.h"
+#include "../include/notation.h"
+
+#include <cctype>
+#include <cstring>
+
+static bool recordFailed(std::string* error, const std::string& reason) {
+    if (error) *error = reason;
+    return false;
+}
+
+// Reads one varint, refusing to run past `end` or beyond 32 bits
+static bool readVarint(const uint8_t*& position, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35 && position < end; shift += 7) {
+        uint8_t byte = *position++;
+        // Only the low four bits of a fifth byte still fit; anything above them would be dropped
+        if (shift == 28 && (byte & 0x70)) return false;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+std::pair<int, int> GameRecord::MoveIterator::operator*() const {
+    // The reader already checked every move, so no bounds are needed here
+    uint32_t cell = 0;
+    const uint8_t* byte = position;
+    for (int shift = 0;; shift += 7) {
+        cell |= static_cast<uint32_t>(*byte & 0x7F) << shift;
+        if (!(*byte++ & 0x80)) break;
+    }
+    cell -= 1;
+    return { static_cast<int>(cell % width) + 1, static_cast<int>(cell / width) + 1 };
+}
+
+GameRecord::MoveIterator& GameRecord::MoveIterator::operator++() {
+    while (*position++ & 0x80) {}
+    return *this;
+}
+
+std::string GameRecord::toText() const {
+    return formatText(std::vector<std::pair<int, int>>(begin(), end()), result);
+}
+
+std::string GameRecord::formatText(const std::vector<std::pair<int, int>>& moves, Result result) {
+    if (moves.empty()) return "";
+    std::string text;
+    for (size_t i = 0; i < moves.size(); i += 2) {
+        text += std::to_string(i / 2 + 1) + ". " + std::to_string(moves[i].first) + "-" + std::to_string(moves[i].second);
+        if (i + 1 < moves.size()) {
+            text += " " + std::to_string(moves[i + 1].first) + "-" + std::to_string(moves[i + 1].second);
+        }
+        text += '\n';
+    }
+    if (result == X_WINS) text += " 1-0";
+    else if (result == O_WINS) text += " 0-1";
+    else text += " 1/2-1/2";
+    return text;
+}
+
+bool GameRecord::parseText(const std::string& text, std::vector<std::pair<int, int>>& moves, Result& result,
+    std::string* error) {
+    const char* cursor = text.data();
+    const char* end = cursor + text.size();
+    if (!Notation::parseGame(cursor, end, moves, result, error)) return false;
+
+    while (cursor < end && std::isspace(static_cast<unsigned char>(*cursor))) ++cursor;
+    if (cursor != end) {
+        if (error) *error = "Unexpected text after the game result";
+        return false;
+    }
+    return true;
+}
+
+void GameRecordWriter::putVarint(uint32_t value) {
+    char bytes[5];
+    int count = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        bytes[count++] = static_cast<char>(value ? byte | 0x80 : byte);
+    } while (value);
+    out.write(bytes, count);
+}
+
+bool GameRecordWriter::open(const std::string& filePath, std::string* error) {
+    close();
+    path = filePath;
+
+    GameRecord::Header header;
+    std::ifstream existing(path, std::ios::binary | std::ios::ate);
+    bool empty = !existing || existing.tellg() <= 0;
+    if (!empty) {
+        existing.seekg(0);
+        if (!existing.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(header.magic, "TTGR", 4) != 0 || header.version != GameRecord::VERSION) {
+            return recordFailed(error, "Invalid game record file " + path);
+        }
+    }
+    existing.close();
+
+    out.open(path, std::ios::binary | std::ios::app);
+    if (!out) return recordFailed(error, "Could not open game record file " + path);
+    if (empty) {
+        std::memcpy(header.magic, "TTGR", 4);
+        header.version = GameRecord::VERSION;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    return out || recordFailed(error, "Could not write game record file " + path);
+}
+
+bool GameRecordWriter::beginGame(int boardWidth, int boardHeight, int matchLength, std::string* error) {
+    if (!isOpen()) return recordFailed(error, "No game record file is open");
+    if (inGame) endGame(GameRecord::UNFINISHED);
+    if (boardWidth < 1 || boardHeight < 1 || matchLength < 1) {
+        return recordFailed(error, "Invalid board for a game record");
+    }
+    width = boardWidth;
+    height = boardHeight;
+    putVarint(static_cast<uint32_t>(width));
+    putVarint(static_cast<uint32_t>(height));
+    putVarint(static_cast<uint32_t>(matchLength));
+    inGame = true;
+    return out || recordFailed(error, "Could not write game record file " + path);
+}
+
+bool GameRecordWriter::addMove(int x, int y, std::string* error) {
+    if (!inGame) return recordFailed(error, "No game record has been begun");
+    if (x < 1 || x > width || y < 1 || y > height) {
+        return recordFailed(error, "Invalid move (" + std::to_string(x) + ", " + std::to_string(y) + ") for a game record");
+    }
+    putVarint(static_cast<uint32_t>((y - 1) * width + (x - 1) + 1));
+    return out || recordFailed(error, "Could not write game record file " + path);
+}
+
+bool GameRecordWriter::endGame(GameRecord::Result result) {
+    if (!inGame) return false;
+    out.put(0);
+    out.put(static_cast<char>(result));
+    inGame = false;
+    return static_cast<bool>(out);
+}
+
+bool GameRecordWriter::writeGame(int boardWidth, int boardHeight, int matchLength,
+    const std::vector<std::pair<int, int>>& moves, GameRecord::Result result, std::string* error) {
+    if (!beginGame(boardWidth, boardHeight, matchLength, error)) return false;
+    for (const auto& move : moves) {
+        if (!addMove(move.first, move.second, error)) {
+            endGame(GameRecord::UNFINISHED);
+            return false;
+        }
+    }
+    return endGame(result) || recordFailed(error, "Could not write game record file " + path);
+}
+
+bool GameRecordWriter::writeText(const std::string& text, int boardWidth, int boardHeight, int matchLength,
+    std::string* error) {
+    std::vector<std::pair<int, int>> moves;
+    GameRecord::Result result;
+    if (!GameRecord::parseText(text, moves, result, error)) return false;
+    return writeGame(boardWidth, boardHeight, matchLength, moves, result, error);
+}
+
+bool GameRecordWriter::flush(std::string* error) {
+    out.flush();
+    return out || recordFailed(error, "Could not write game record file " + path);
+}
+
+void GameRecordWriter::close() {
+    if (!isOpen()) return;
+    if (inGame) endGame(GameRecord::UNFINISHED);
+    flush();
+    out.close();
+}
+
+bool GameRecordReader::open(const std::string& path, std::string* error) {
+    close();
+    GameRecord::Header header;
+    if (!file.open(path) || file.size() < sizeof(header)) {
+        file.close();
+        return recordFailed(error, "Could not open game record file " + path);
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, "TTGR", 4) != 0 || header.version != GameRecord::VERSION) {
+        file.close();
+        return recordFailed(error, "Invalid game record file " + path);
+    }
+    rewind();
+    return true;
+}
+
+void GameRecordReader::close() {
+    file.close();
+    cursor = end = nullptr;
+}
+
+void GameRecordReader::rewind() {
+    if (!isOpen()) return;
+    cursor = file.data() + sizeof(GameRecord::Header);
+    end = file.data() + file.size();
+}
+
+bool GameRecordReader::next(GameRecord& record, std::string* error) {
+    if (cursor == end) return false;
+
+    const uint8_t* position = cursor;
+    uint32_t width, height, matchLength;
+    bool valid = readVarint(position, end, width) && readVarint(position, end, height)
+        && readVarint(position, end, matchLength)
+        && width >= 1 && height >= 1 && matchLength >= 1 && width <= 0xFFFF && height <= 0xFFFF;
+
+    uint32_t cells = valid ? width * height : 0;
+    const uint8_t* moves = position;
+    size_t moveCount = 0;
+    while (valid) {
+        const uint8_t* moveEnd = position;
+        uint32_t value;
+        if (!readVarint(position, end, value) || value > cells) {
+            valid = false;
+            break;
+        }
+        if (value == 0) {
+            record.moveBytesEnd = moveEnd;
+            break;
+        }
+        moveCount++;
+    }
+    valid = valid && position < end && *position <= GameRecord::DRAW;
+
+    if (!valid) {
+        size_t offset = static_cast<size_t>(cursor - file.data());
+        cursor = end;
+        return recordFailed(error, "Corrupt or truncated game record at byte " + std::to_string(offset));
+    }
+
+    record.width = static_cast<int>(width);
+    record.height = static_cast<int>(height);
+    record.matchLength = static_cast<int>(matchLength);
+    record.result = static_cast<GameRecord::Result>(*position++);
+    record.moveCount = moveCount;
+    record.moveBytes = moves;
+    cursor = position;
+    return true;
+}
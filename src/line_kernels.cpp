@@ -0,0 +1,165 @@
+#include "../include/line_kernels.h"
+
+#include <bitset>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LINE_KERNELS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2,popcnt")))
+#endif
+#endif
+
+namespace {
+    int popcount(uint64_t value) {
+        return static_cast<int>(std::bitset<64>(value).count());
+    }
+
+    // Word index and bit offset of board bit `bit`, which may be negative
+    void splitBit(int bit, int& word, int& shift) {
+        word = bit >= 0 ? bit / 64 : -((-bit + 63) / 64);
+        shift = bit - word * 64;
+    }
+
+    uint64_t shiftedWord(const uint64_t* words, int bit) {
+        int q, r;
+        splitBit(bit, q, r);
+        // (hi << 1) << (63 - r) avoids the undefined shift by 64 when r == 0
+        return (words[q] >> r) | ((words[q + 1] << 1) << (63 - r));
+    }
+
+    int countRunsScalar(const uint64_t* words, int boardWords, int step, int length) {
+        if (length <= 0) return 0;
+        int total = 0;
+        for (int w = 0; w < boardWords; ++w) {
+            uint64_t acc = words[w];
+            for (int k = 1; k < length && acc; ++k) {
+                acc &= shiftedWord(words, w * 64 + k * step);
+            }
+            total += popcount(acc);
+        }
+        return total;
+    }
+
+    bool hasRunScalar(const uint64_t* words, int boardWords, int step, int length) {
+        if (length <= 0) return false;
+        for (int w = 0; w < boardWords; ++w) {
+            uint64_t acc = words[w];
+            for (int k = 1; k < length && acc; ++k) {
+                acc &= shiftedWord(words, w * 64 + k * step);
+            }
+            if (acc) return true;
+        }
+        return false;
+    }
+
+#ifdef LINE_KERNELS_X86
+    // Vector shifts by 64 or more give zero, so r == 0 needs no special case here
+
+    __m128i shiftedPair(const uint64_t* words, int bit) {
+        int q, r;
+        splitBit(bit, q, r);
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + q));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + q + 1));
+        return _mm_or_si128(_mm_srl_epi64(lo, _mm_cvtsi32_si128(r)), _mm_sll_epi64(hi, _mm_cvtsi32_si128(64 - r)));
+    }
+
+    __m128i runStartsSse2(const uint64_t* words, int w, int step, int length) {
+        __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + w));
+        for (int k = 1; k < length; ++k) {
+            acc = _mm_and_si128(acc, shiftedPair(words, w * 64 + k * step));
+        }
+        return acc;
+    }
+
+    int countRunsSse2(const uint64_t* words, int boardWords, int step, int length) {
+        if (length <= 0) return 0;
+        int total = 0;
+        alignas(16) uint64_t lanes[2];
+        for (int w = 0; w < boardWords; w += 2) {
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), runStartsSse2(words, w, step, length));
+            total += popcount(lanes[0]) + popcount(lanes[1]);
+        }
+        return total;
+    }
+
+    bool hasRunSse2(const uint64_t* words, int boardWords, int step, int length) {
+        if (length <= 0) return false;
+        for (int w = 0; w < boardWords; w += 2) {
+            __m128i acc = runStartsSse2(words, w, step, length);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF) return true;
+        }
+        return false;
+    }
+
+    AVX2_TARGET __m256i runStartsAvx2(const uint64_t* words, int w, int step, int length) {
+        __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + w));
+        for (int k = 1; k < length; ++k) {
+            int q, r;
+            splitBit(w * 64 + k * step, q, r);
+            __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + q));
+            __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + q + 1));
+            __m256i shifted = _mm256_or_si256(_mm256_srl_epi64(lo, _mm_cvtsi32_si128(r)),
+                _mm256_sll_epi64(hi, _mm_cvtsi32_si128(64 - r)));
+            acc = _mm256_and_si256(acc, shifted);
+        }
+        return acc;
+    }
+
+    AVX2_TARGET int countRunsAvx2(const uint64_t* words, int boardWords, int step, int length) {
+        if (length <= 0) return 0;
+        int total = 0;
+        alignas(32) uint64_t lanes[4];
+        for (int w = 0; w < boardWords; w += 4) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), runStartsAvx2(words, w, step, length));
+            total += popcount(lanes[0]) + popcount(lanes[1]) + popcount(lanes[2]) + popcount(lanes[3]);
+        }
+        return total;
+    }
+
+    AVX2_TARGET bool hasRunAvx2(const uint64_t* words, int boardWords, int step, int length) {
+        if (length <= 0) return false;
+        for (int w = 0; w < boardWords; w += 4) {
+            __m256i acc = runStartsAvx2(words, w, step, length);
+            if (!_mm256_testz_si256(acc, acc)) return true;
+        }
+        return false;
+    }
+
+    bool cpuHasAvx2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;  // OS must save the YMM registers
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+    }
+#endif
+}
+
+const LineKernels& LineKernels::scalar() {
+    static const LineKernels kernels = { countRunsScalar, hasRunScalar, "scalar" };
+    return kernels;
+}
+
+const LineKernels& LineKernels::active() {
+#ifdef LINE_KERNELS_X86
+    static const LineKernels avx2 = { countRunsAvx2, hasRunAvx2, "avx2" };
+    static const LineKernels sse2 = { countRunsSse2, hasRunSse2, "sse2" };
+    static const LineKernels& chosen = cpuHasAvx2() ? avx2 : sse2;
+    return chosen;
+#else
+    return scalar();
+#endif
+}
@@ -0,0 +1,209 @@
+#include "../include/notation.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const int MAX_BOARD_SIDE = 1000;
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Reads a run of digits; false if there is none or it is absurdly large
+static bool readNumber(const char*& position, const char* end, int& value) {
+    if (position == end || !isDigit(*position)) return false;
+    value = 0;
+    while (position < end && isDigit(*position)) {
+        if (value > 1000000) return false;
+        value = value * 10 + (*position++ - '0');
+    }
+    return true;
+}
+
+static bool invalidPosition(std::string* error, const char* reason) {
+    if (error) *error = std::string("Invalid position: ") + reason;
+    return false;
+}
+
+static bool invalidToken(std::string* error, const char* token, const char* end) {
+    if (error) {
+        const char* tokenEnd = token;
+        while (tokenEnd < end && !isBlank(*tokenEnd)) ++tokenEnd;
+        *error = "Invalid move text \"" + std::string(token, tokenEnd) + "\"";
+    }
+    return false;
+}
+
+bool Notation::parsePosition(const char*& cursor, const char* end, ParsedPosition& position, std::string* error) {
+    const char* p = cursor;
+    position.cells.clear();
+    position.width = 0;
+    position.height = 0;
+
+    // Rows, each closed by a '/' or by the space before the side to move
+    int rowLength = 0;
+    while (true) {
+        char c = p < end ? *p : ' ';
+        if (c == '/' || isBlank(c)) {
+            if (rowLength == 0) return invalidPosition(error, "empty row");
+            if (position.height == 0) position.width = rowLength;
+            else if (rowLength != position.width) return invalidPosition(error, "rows have different lengths");
+            if (++position.height > MAX_BOARD_SIDE) return invalidPosition(error, "too many rows");
+            rowLength = 0;
+            if (c != '/') break;
+            ++p;
+        }
+        else if (c == 'x' || c == 'X' || c == 'o' || c == 'O') {
+            position.cells.push_back((c == 'x' || c == 'X') ? 2 : 1);
+            ++rowLength;
+            ++p;
+        }
+        else if (isDigit(c)) {
+            int run;
+            if (!readNumber(p, end, run) || run == 0 || rowLength + run > MAX_BOARD_SIDE) {
+                return invalidPosition(error, "bad run of empty cells");
+            }
+            position.cells.insert(position.cells.end(), run, 0);
+            rowLength += run;
+        }
+        else {
+            return invalidPosition(error, "unexpected character in the board");
+        }
+    }
+
+    // Side to move and match length, then nothing else on the line
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (p == end || (*p != 'x' && *p != 'X' && *p != 'o' && *p != 'O')) return invalidPosition(error, "missing side to move");
+    position.xToMove = *p == 'x' || *p == 'X';
+    ++p;
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (!readNumber(p, end, position.matchLength) || position.matchLength < 1) return invalidPosition(error, "missing match length");
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    if (p < end && *p != '\n') return invalidPosition(error, "unexpected text after the match length");
+    if (p < end) ++p;
+
+    cursor = p;
+    return true;
+}
+
+bool Notation::parseGame(const char*& cursor, const char* end,
+    std::vector<std::pair<int, int>>& moves, GameRecord::Result& result, std::string* error) {
+    const char* p = cursor;
+    moves.clear();
+    result = GameRecord::UNFINISHED;
+
+    while (true) {
+        while (p < end && isBlank(*p)) ++p;
+        if (p == end) break;
+
+        const char* token = p;
+        if (end - p >= 7 && std::memcmp(p, "1/2-1/2", 7) == 0 && (end - p == 7 || isBlank(p[7]))) {
+            result = GameRecord::DRAW;
+            p += 7;
+            break;
+        }
+
+        int first, second;
+        if (!readNumber(p, end, first)) return invalidToken(error, token, end);
+        if (p < end && *p == '.') {
+            // Move number
+            ++p;
+            if (p < end && !isBlank(*p)) return invalidToken(error, token, end);
+            continue;
+        }
+        if (p == end || *p != '-') return invalidToken(error, token, end);
+        ++p;
+        if (!readNumber(p, end, second) || (p < end && !isBlank(*p))) return invalidToken(error, token, end);
+
+        // "1-0" and "0-1" cannot be moves, since coordinates start at 1
+        if (first == 1 && second == 0) {
+            result = GameRecord::X_WINS;
+            break;
+        }
+        if (first == 0 && second == 1) {
+            result = GameRecord::O_WINS;
+            break;
+        }
+        if (first < 1 || second < 1) return invalidToken(error, token, end);
+        moves.emplace_back(first, second);
+    }
+
+    cursor = p;
+    return true;
+}
+
+std::string Notation::formatPosition(const ParsedPosition& position) {
+    std::string text;
+    text.reserve(position.cells.size() + position.height + 8);
+    for (int y = 0; y < position.height; ++y) {
+        if (y > 0) text += '/';
+        int empty = 0;
+        for (int x = 0; x < position.width; ++x) {
+            uint8_t cell = position.cells[y * position.width + x];
+            if (cell == 0) {
+                ++empty;
+                continue;
+            }
+            if (empty) text += std::to_string(empty);
+            empty = 0;
+            text += cell == 2 ? 'x' : 'o';
+        }
+        if (empty) text += std::to_string(empty);
+    }
+    text += position.xToMove ? " x " : " o ";
+    text += std::to_string(position.matchLength);
+    return text;
+}
+
+bool NotationReader::open(const std::string& path) {
+    close();
+    if (!file.open(path)) {
+        message = "Could not open " + path;
+        return false;
+    }
+    cursor = reinterpret_cast<const char*>(file.data());
+    end = cursor + file.size();
+    return true;
+}
+
+void NotationReader::close() {
+    file.close();
+    cursor = end = nullptr;
+    error = false;
+    message.clear();
+}
+
+bool NotationReader::skipBlank() {
+    while (cursor < end && isBlank(*cursor)) ++cursor;
+    return cursor < end;
+}
+
+void NotationReader::reportError(const char* start) {
+    const char* begin = reinterpret_cast<const char*>(file.data());
+    error = true;
+    message += " in the entry starting at line " + std::to_string(std::count(begin, start, '\n') + 1);
+}
+
+bool NotationReader::nextPosition(ParsedPosition& position) {
+    if (error || !skipBlank()) return false;
+    const char* start = cursor;
+    if (!Notation::parsePosition(cursor, end, position, &message)) {
+        reportError(start);
+        return false;
+    }
+    return true;
+}
+
+bool NotationReader::nextGame(std::vector<std::pair<int, int>>& moves, GameRecord::Result& result) {
+    if (error || !skipBlank()) return false;
+    const char* start = cursor;
+    if (!Notation::parseGame(cursor, end, moves, result, &message)) {
+        reportError(start);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,83 @@
+#include "../include/opening_book.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+static bool loadFailed(std::string* error, const std::string& reason) {
+    if (error) *error = reason;
+    return false;
+}
+
+bool OpeningBook::load(const std::string& path, std::string* error) {
+    entries = nullptr;
+    entryCount = 0;
+    if (!file.open(path) || file.size() < sizeof(Header)) {
+        file.close();
+        return loadFailed(error, "Could not open opening book " + path);
+    }
+
+    Header header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, "TTOB", 4) != 0 || header.version != VERSION
+        || (file.size() - sizeof(Header)) / sizeof(Entry) != header.entryCount
+        || (file.size() - sizeof(Header)) % sizeof(Entry) != 0) {
+        file.close();
+        return loadFailed(error, "Invalid opening book " + path);
+    }
+
+    width = static_cast<int>(header.width);
+    height = static_cast<int>(header.height);
+    matchLength = static_cast<int>(header.matchLength);
+    entryCount = static_cast<size_t>(header.entryCount);
+    // The mapping is page-aligned and the header is 32 bytes, so entries are aligned too
+    entries = reinterpret_cast<const Entry*>(file.data() + sizeof(Header));
+    return true;
+}
+
+std::pair<const OpeningBook::Entry*, const OpeningBook::Entry*> OpeningBook::probe(uint64_t key) const {
+    const Entry* end = entries + entryCount;
+    const Entry* first = std::lower_bound(entries, end, key,
+        [](const Entry& entry, uint64_t value) { return entry.key < value; });
+    const Entry* last = first;
+    while (last != end && last->key == key) ++last;
+    return { first, last };
+}
+
+void OpeningBookBuilder::add(uint64_t key, int move, uint32_t weight) {
+    weights[{ key, move }] += weight;
+}
+
+bool OpeningBookBuilder::contains(uint64_t key) const {
+    auto it = weights.lower_bound({ key, -1 });
+    return it != weights.end() && it->first.first == key;
+}
+
+bool OpeningBookBuilder::write(const std::string& path, int width, int height, int matchLength, std::string* error) const {
+    std::vector<OpeningBook::Entry> entries;
+    entries.reserve(weights.size());
+    for (const auto& item : weights) {
+        OpeningBook::Entry entry;
+        entry.key = item.first.first;
+        entry.move = static_cast<uint16_t>(item.first.second);
+        entry.weight = static_cast<uint16_t>(std::min<uint32_t>(item.second, 0xFFFF));
+        entry.reserved = 0;
+        entries.push_back(entry);
+    }
+
+    OpeningBook::Header header;
+    std::memcpy(header.magic, "TTOB", 4);
+    header.version = OpeningBook::VERSION;
+    header.width = width;
+    header.height = height;
+    header.matchLength = matchLength;
+    header.reserved = 0;
+    header.entryCount = entries.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(OpeningBook::Entry)));
+    if (!out) return loadFailed(error, "Could not write opening book " + path);
+    return true;
+}
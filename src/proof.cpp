@@ -0,0 +1,253 @@
+#include "../include/tictactoe.h"
+
+// Depth-first proof-number search (df-pn). Each run proves or disproves one goal,
+// "the attacker wins", so solve() uses one run for the side to move and, if that
+// fails, a second one for the opponent; if both fail the position is a draw.
+
+ProofTable::ProofTable(size_t megabytes) {
+    size_t bytes = std::max<size_t>(1, megabytes) * 1024 * 1024;
+    size_t buckets = 1;
+    while (buckets * 2 * WAYS * sizeof(Entry) <= bytes) {
+        buckets *= 2;
+    }
+    entries.resize(buckets * WAYS);
+    bucketMask = buckets - 1;
+}
+
+bool ProofTable::lookup(uint64_t key, Entry& entry) const {
+    const Entry* bucket = &entries[(key & bucketMask) * WAYS];
+    for (int i = 0; i < WAYS; ++i) {
+        if (bucket[i].work != 0 && bucket[i].key == key) {
+            entry = bucket[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+void ProofTable::store(uint64_t key, uint32_t phi, uint32_t delta, uint32_t work) {
+    Entry* bucket = &entries[(key & bucketMask) * WAYS];
+    Entry* target = nullptr;
+    for (int i = 0; i < WAYS && !target; ++i) {
+        if (bucket[i].work == 0 || bucket[i].key == key) target = &bucket[i];
+    }
+    if (!target) {
+        // Keep the entries that were expensive to compute; a cheap one, solved or
+        // not, is quickly found again
+        target = &bucket[0];
+        for (int i = 1; i < WAYS; ++i) {
+            if (bucket[i].work < target->work) target = &bucket[i];
+        }
+    }
+    target->key = key;
+    target->phi = phi;
+    target->delta = delta;
+    target->work = std::max<uint32_t>(1, work);
+}
+
+void ProofTable::clear() {
+    std::fill(entries.begin(), entries.end(), Entry());
+}
+
+unsigned long long TicTacToe::childHash(int cell, int player) const {
+    unsigned long long best = ~0ULL;
+    for (int t = 0; t < zobrist->symmetryCount(); ++t) {
+        best = std::min(best, boardHashes[t] ^ zobrist->key(t, cell, player));
+    }
+    return best;
+}
+
+bool TicTacToe::proofTerminal(int player, int attacker, uint32_t& phi, uint32_t& delta) const {
+    // The last move made a line: the side to move has lost, whichever goal it had
+    if (winnerPlayer != 0) {
+        phi = ProofTable::INF;
+        delta = 0;
+        return true;
+    }
+    // A draw is a success only for the defender
+    if (stoneCount == boardSizeX * boardSizeY) {
+        phi = player == attacker ? ProofTable::INF : 0;
+        delta = player == attacker ? 0 : ProofTable::INF;
+        return true;
+    }
+    return false;
+}
+
+int TicTacToe::findWinningCell(int player) const {
+    for (int cell = 0; cell < boardSizeX * boardSizeY; ++cell) {
+        int x = cell % boardSizeX, y = cell / boardSizeX;
+        if (cellAt(x, y) == 0 && isWinningMove(x + 1, y + 1, player)) return cell;
+    }
+    return -1;
+}
+
+void TicTacToe::proofChildren(int player, std::vector<std::pair<int, unsigned long long>>& children) const {
+    children.clear();
+    for (int cell = 0; cell < boardSizeX * boardSizeY; ++cell) {
+        if (cellAt(cell % boardSizeX, cell / boardSizeX) != 0) continue;
+        // Symmetric children share a table entry, so only one of them is needed
+        unsigned long long hash = childHash(cell, player);
+        bool duplicate = false;
+        for (const auto& child : children) {
+            if (child.second == hash) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate) children.emplace_back(cell, hash);
+    }
+}
+
+void TicTacToe::proofSearch(ProofSearch& search, int player, uint32_t thresholdPhi, uint32_t thresholdDelta) {
+    unsigned long long hash = canonicalHash();
+    unsigned long long startNodes = search.nodes++;
+    if (search.maxNodes && search.nodes > search.maxNodes) {
+        search.aborted = true;
+        return;
+    }
+
+    uint32_t phi, delta;
+    if (proofTerminal(player, search.attacker, phi, delta)) {
+        search.table.store(hash, phi, delta, 1);
+        return;
+    }
+    if (findWinningCell(player) >= 0) {
+        // Winning on the spot reaches either side's goal
+        search.table.store(hash, 0, ProofTable::INF, 1);
+        return;
+    }
+
+    int opponent = 3 - player;
+    std::vector<std::pair<int, unsigned long long>> children;
+    proofChildren(player, children);
+
+    while (true) {
+        // phi = min over children of delta, delta = sum over children of phi
+        phi = ProofTable::INF;
+        delta = 0;
+        uint32_t secondDelta = ProofTable::INF;
+        int bestChild = -1;
+        uint32_t bestChildPhi = 0;
+        for (size_t i = 0; i < children.size(); ++i) {
+            ProofTable::Entry entry;
+            uint32_t childPhi = 1, childDelta = 1;
+            if (search.table.lookup(children[i].second, entry)) {
+                childPhi = entry.phi;
+                childDelta = entry.delta;
+            }
+            delta = std::min(ProofTable::INF, delta + childPhi);
+            if (childDelta < phi) {
+                secondDelta = phi;
+                phi = childDelta;
+                bestChild = static_cast<int>(i);
+                bestChildPhi = childPhi;
+            }
+            else if (childDelta < secondDelta) {
+                secondDelta = childDelta;
+            }
+        }
+
+        if (phi >= thresholdPhi || delta >= thresholdDelta || bestChild < 0 || search.aborted) break;
+
+        uint32_t childThresholdPhi = std::min<uint64_t>(ProofTable::INF,
+            static_cast<uint64_t>(thresholdDelta) - delta + bestChildPhi);
+        uint32_t childThresholdDelta = std::min(thresholdPhi, secondDelta + 1);
+
+        int cell = children[bestChild].first;
+        int x = cell % boardSizeX + 1, y = cell / boardSizeX + 1;
+        makeMove(x, y, player);
+        proofSearch(search, opponent, childThresholdPhi, childThresholdDelta);
+        undoMove(x, y);
+    }
+
+    unsigned long long work = search.nodes - startNodes;
+    search.table.store(hash, phi, delta, static_cast<uint32_t>(std::min<unsigned long long>(work, 0xFFFFFFFFULL)));
+}
+
+// Picks the child the line continues with, or -1 if the table no longer holds it
+static int chooseLineChild(const ProofTable& table, const ProofTable::Entry& entry,
+    const std::vector<std::pair<int, unsigned long long>>& children) {
+    // The proving side plays a child it has disproven for the other side; the
+    // losing side may play anything, so follow the reply that holds out longest
+    int chosen = -1;
+    uint32_t chosenWork = 0;
+    for (size_t i = 0; i < children.size(); ++i) {
+        ProofTable::Entry child;
+        if (!table.lookup(children[i].second, child)) continue;
+        bool wanted = entry.phi == 0 ? child.delta == 0 : child.phi == 0;
+        if (wanted && (chosen < 0 || (entry.phi != 0 && child.work > chosenWork))) {
+            chosen = static_cast<int>(i);
+            chosenWork = child.work;
+            if (entry.phi == 0) break;
+        }
+    }
+    return chosen;
+}
+
+bool TicTacToe::proofLine(ProofSearch& search, int player, std::vector<std::pair<int, int>>& line) {
+    if (isTerminal()) return true;
+
+    int winningCell = findWinningCell(player);
+    if (winningCell >= 0) {
+        line.emplace_back(winningCell % boardSizeX + 1, winningCell / boardSizeX + 1);
+        return true;
+    }
+
+    // Entries along the line may have been replaced since the proof, either this
+    // node's or the child it needs. Proving the node again from here refills both;
+    // only the node limit can stop that, and then the line is reported as cut short.
+    std::vector<std::pair<int, unsigned long long>> children;
+    proofChildren(player, children);
+    ProofTable::Entry entry;
+    int chosen = -1;
+    for (int attempt = 0; attempt < 2 && chosen < 0; ++attempt) {
+        if (attempt > 0) {
+            proofSearch(search, player, ProofTable::INF, ProofTable::INF);
+            if (search.aborted) return false;
+        }
+        if (search.table.lookup(canonicalHash(), entry) && (entry.phi == 0 || entry.delta == 0)) {
+            chosen = chooseLineChild(search.table, entry, children);
+        }
+    }
+    if (chosen < 0) return false;
+
+    int cell = children[chosen].first;
+    int x = cell % boardSizeX + 1, y = cell / boardSizeX + 1;
+    line.emplace_back(x, y);
+    makeMove(x, y, player);
+    bool complete = proofLine(search, 3 - player, line);
+    undoMove(x, y);
+    return complete;
+}
+
+ProofResult TicTacToe::solve(unsigned long long maxNodes, size_t tableMB) {
+    ProofResult result;
+    int player = isXTurn ? 2 : 1;
+    if (isTerminal()) {
+        result.value = winnerPlayer == 0 ? ProofResult::DRAW : (winnerPlayer == player ? ProofResult::WIN : ProofResult::LOSS);
+        return result;
+    }
+
+    ProofSearch search(tableMB);
+    search.maxNodes = maxNodes;
+
+    for (int attacker : { player, 3 - player }) {
+        search.attacker = attacker;
+        search.table.clear();
+        proofSearch(search, player, ProofTable::INF, ProofTable::INF);
+        if (search.aborted) break;
+
+        ProofTable::Entry root;
+        search.table.lookup(canonicalHash(), root);
+        bool attackerWins = (attacker == player) ? root.phi == 0 : root.delta == 0;
+        if (attackerWins) {
+            result.value = attacker == player ? ProofResult::WIN : ProofResult::LOSS;
+            result.lineComplete = proofLine(search, player, result.line);
+            break;
+        }
+        if (attacker != player) result.value = ProofResult::DRAW;
+    }
+
+    result.nodes = search.nodes;
+    return result;
+}
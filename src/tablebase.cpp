@@ -0,0 +1,167 @@
+#include "../include/tablebase.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+    bool loadFailed(std::string* error, const std::string& reason) {
+        if (error) *error = reason;
+        return false;
+    }
+
+    // Cell masks of every line of matchLength cells on the board
+    std::vector<uint32_t> buildLineMasks(int width, int height, int matchLength) {
+        static const int directions[4][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, -1 } };
+        std::vector<uint32_t> masks;
+        for (const auto& dir : directions) {
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    int endX = x + dir[0] * (matchLength - 1);
+                    int endY = y + dir[1] * (matchLength - 1);
+                    if (endX < 0 || endX >= width || endY < 0 || endY >= height) continue;
+                    uint32_t mask = 0;
+                    for (int i = 0; i < matchLength; ++i) {
+                        mask |= 1u << ((y + dir[1] * i) * width + x + dir[0] * i);
+                    }
+                    masks.push_back(mask);
+                }
+            }
+        }
+        return masks;
+    }
+
+    bool hasLine(uint32_t stones, const std::vector<uint32_t>& masks) {
+        for (uint32_t mask : masks) {
+            if ((stones & mask) == mask) return true;
+        }
+        return false;
+    }
+
+    // Per-player stone masks of a base-3 index (bit i set for cell i)
+    void decode(uint64_t index, int cells, uint32_t stones[3]) {
+        stones[1] = stones[2] = 0;
+        for (int i = 0; i < cells; ++i) {
+            int digit = static_cast<int>(index % 3);
+            index /= 3;
+            if (digit) stones[digit] |= 1u << i;
+        }
+    }
+}
+
+bool Tablebase::generate(int width, int height, int matchLength, const std::string& path, std::string* error) {
+    int cells = width * height;
+    if (width <= 0 || height <= 0 || matchLength <= 0 || cells > MAX_CELLS) {
+        return loadFailed(error, "Tablebases only cover boards of up to " + std::to_string(MAX_CELLS) + " cells");
+    }
+
+    std::vector<uint64_t> weights(cells);
+    for (int i = 0; i < cells; ++i) weights[i] = cellWeight(i);
+    uint64_t count = cellWeight(cells);
+    auto masks = buildLineMasks(width, height, matchLength);
+
+    // Forward pass: collect the reachable positions layer by layer (layer n has n stones).
+    // The table doubles as the visited set until the backward pass overwrites it;
+    // unreachable positions keep their 0 (UNKNOWN).
+    const uint8_t reachedMark = 0xFF;
+    std::vector<uint8_t> table(count, UNKNOWN);
+    std::vector<std::vector<uint32_t>> layers(cells + 1);
+    layers[0].push_back(0);
+    table[0] = reachedMark;
+    for (int n = 0; n < cells; ++n) {
+        int player = n % 2 == 0 ? 2 : 1;
+        uint32_t stones[3];
+        for (uint32_t index : layers[n]) {
+            decode(index, cells, stones);
+            if (hasLine(stones[3 - player], masks)) continue;
+            uint32_t occupied = stones[1] | stones[2];
+            for (int i = 0; i < cells; ++i) {
+                if (occupied & (1u << i)) continue;
+                uint64_t child = index + player * weights[i];
+                if (table[child]) continue;
+                table[child] = reachedMark;
+                layers[n + 1].push_back(static_cast<uint32_t>(child));
+            }
+        }
+    }
+
+    // Backward pass: every child lives in the next layer, so it is already solved
+    for (int n = cells; n >= 0; --n) {
+        int player = n % 2 == 0 ? 2 : 1;
+        uint32_t stones[3];
+        for (uint32_t index : layers[n]) {
+            decode(index, cells, stones);
+            if (hasLine(stones[3 - player], masks)) {
+                table[index] = LOSS;
+                continue;
+            }
+            if (n == cells) {
+                table[index] = DRAW;
+                continue;
+            }
+
+            // Win as fast as possible, otherwise draw, otherwise lose as slowly as possible
+            int bestWin = -1, longestLoss = -1;
+            bool canDraw = false;
+            uint32_t occupied = stones[1] | stones[2];
+            for (int i = 0; i < cells; ++i) {
+                if (occupied & (1u << i)) continue;
+                uint8_t entry = table[index + player * weights[i]];
+                int distance = distanceOf(entry) + 1;
+                switch (valueOf(entry)) {
+                case LOSS:
+                    if (bestWin < 0 || distance < bestWin) bestWin = distance;
+                    break;
+                case WIN:
+                    longestLoss = std::max(longestLoss, distance);
+                    break;
+                default:
+                    canDraw = true;
+                    break;
+                }
+            }
+            if (bestWin >= 0) table[index] = static_cast<uint8_t>(WIN | (bestWin << 2));
+            else if (canDraw) table[index] = DRAW;
+            else table[index] = static_cast<uint8_t>(LOSS | (longestLoss << 2));
+        }
+    }
+
+    Header header;
+    std::memcpy(header.magic, "TTTB", 4);
+    header.version = VERSION;
+    header.width = width;
+    header.height = height;
+    header.matchLength = matchLength;
+    header.reserved = 0;
+    header.entryCount = count;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size()));
+    if (!out) return loadFailed(error, "Could not write tablebase " + path);
+    return true;
+}
+
+bool Tablebase::load(const std::string& path, std::string* error) {
+    entries = nullptr;
+    if (!file.open(path) || file.size() < sizeof(Header)) {
+        file.close();
+        return loadFailed(error, "Could not open tablebase " + path);
+    }
+
+    Header header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, "TTTB", 4) != 0 || header.version != VERSION
+        || file.size() - sizeof(Header) != header.entryCount) {
+        file.close();
+        return loadFailed(error, "Invalid tablebase " + path);
+    }
+
+    width = static_cast<int>(header.width);
+    height = static_cast<int>(header.height);
+    matchLength = static_cast<int>(header.matchLength);
+    entryCount = header.entryCount;
+    entries = file.data() + sizeof(Header);
+    return true;
+}
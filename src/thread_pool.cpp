@@ -0,0 +1,85 @@
+#include "../include/thread_pool.h"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&WorkStealingPool::run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    Queue& queue = *queues[nextQueue++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        ++queued;
+        ++pending;
+    }
+    workAvailable.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this] { return pending == 0; });
+}
+
+bool WorkStealingPool::tryPop(int worker, Task& task) {
+    size_t count = queues.size();
+    for (size_t i = 0; i < count; ++i) {
+        Queue& queue = *queues[(worker + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        // Newest from our own deque, oldest from anyone else's
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(int worker) {
+    while (true) {
+        Task task;
+        if (tryPop(worker, task)) {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                --queued;
+            }
+            task(worker);
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--pending == 0) allDone.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workAvailable.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
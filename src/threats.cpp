@@ -0,0 +1,103 @@
+#include "../include/tictactoe.h"
+
+// Threat-sequence (VCF) search. Only forcing moves are tried: moves that leave a
+// window one stone short of a line with no opponent stone in it, so the opponent
+// has exactly one reply. That keeps the tree narrow enough to read far ahead.
+
+void TicTacToe::collectThreatCells(int player, int stonesInWindow, std::vector<int>& cells) const {
+    int own = player - 1;
+    int other = 1 - own;
+    cells.clear();
+
+    for (int w = 0; w < windowCount; ++w) {
+        if (windowStones[own][w] != stonesInWindow || windowStones[other][w] != 0) continue;
+        for (int k = 0; k < matchLength; ++k) {
+            int cell = windowCells[w * matchLength + k];
+            if (cellAt(cell % boardSizeX, cell / boardSizeX) == 0) cells.push_back(cell);
+        }
+    }
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+}
+
+bool TicTacToe::searchThreats(int attacker, int depthLeft, std::vector<int>& line) {
+    int defender = 3 - attacker;
+    // Scratch lists live in threatBuffers, one set per remaining depth, so nodes do not allocate
+    std::vector<int>& cells = threatBuffers[depthLeft * 3];
+    std::vector<int>& defenderThreats = threatBuffers[depthLeft * 3 + 1];
+    std::vector<int>& replies = threatBuffers[depthLeft * 3 + 2];
+
+    if (!countSearchNode()) return false;
+
+    // A win on the spot ends the sequence
+    collectThreatCells(attacker, matchLength - 1, cells);
+    if (!cells.empty()) {
+        line.push_back(cells.front());
+        return true;
+    }
+    if (depthLeft <= 0) return false;
+
+    // If the defender threatens to win, the only playable move is the block
+    collectThreatCells(defender, matchLength - 1, defenderThreats);
+    if (defenderThreats.size() > 1) return false;
+
+    collectThreatCells(attacker, matchLength - 2, cells);
+    if (!defenderThreats.empty()) {
+        int block = defenderThreats.front();
+        bool forcing = std::find(cells.begin(), cells.end(), block) != cells.end();
+        cells.assign(forcing ? 1 : 0, block);
+    }
+
+    for (int cell : cells) {
+        int x = cell % boardSizeX + 1, y = cell / boardSizeX + 1;
+        makeMove(x, y, attacker);
+        collectThreatCells(attacker, matchLength - 1, replies);
+
+        if (replies.size() >= 2) {
+            // Two winning cells: the defender can only block one of them
+            undoMove(x, y);
+            line.push_back(cell);
+            line.push_back(replies[0]);
+            line.push_back(replies[1]);
+            return true;
+        }
+        if (replies.size() == 1) {
+            int block = replies.front();
+            int bx = block % boardSizeX + 1, by = block / boardSizeX + 1;
+            makeMove(bx, by, defender);
+            size_t mark = line.size();
+            line.push_back(cell);
+            line.push_back(block);
+            bool found = searchThreats(attacker, depthLeft - 1, line);
+            undoMove(bx, by);
+            if (found) {
+                undoMove(x, y);
+                return true;
+            }
+            line.resize(mark);
+        }
+        undoMove(x, y);
+        if (searchControl && searchControl->stopped) return false;
+    }
+    return false;
+}
+
+std::vector<std::pair<int, int>> TicTacToe::findThreatSequence(bool isMaximizing, int maxDepth) {
+    std::vector<std::pair<int, int>> sequence;
+    if (isTerminal()) return sequence;
+
+    size_t buffers = static_cast<size_t>(std::max(maxDepth, 0) + 1) * 3;
+    if (threatBuffers.size() < buffers) threatBuffers.resize(buffers);
+
+    std::vector<int> line;
+    if (searchThreats(isMaximizing ? 2 : 1, maxDepth, line)) {
+        for (int cell : line) {
+            sequence.emplace_back(cell % boardSizeX + 1, cell / boardSizeX + 1);
+        }
+    }
+    return sequence;
+}
+
+void TicTacToe::setThreatSearchDepth(int depth) {
+    threatSearchDepth = std::max(0, depth);
+}
@@ -1,75 +1,186 @@
 #include "../include/tictactoe.h"
 
 void TicTacToe::fillBoard() {
-    board.resize(boardSizeY, std::vector<int>(boardSizeX, 0));
+    // reset() lands here too; the bitboards are cleared in place once they exist
+    for (Bitboard& board : stones) {
+        if (board.stride() == boardSizeX + 1) board.reset();
+        else board = Bitboard(boardSizeX, boardSizeY, matchLength);
+    }
+    int stride = stones[0].stride();
+    lineSteps[0] = 1;
+    lineSteps[1] = stride;
+    lineSteps[2] = stride + 1;
+    lineSteps[3] = 1 - stride;
+
+    for (int p = 0; p < 2; ++p) {
+        windowStones[p].assign(windowCount, 0);
+        openWindows[p].assign(matchLength + 1, 0);
+        openWindows[p][0] = windowCount;
+        potentialWindows[p] = windowCount;
+    }
+
+    rebuildCandidates();
 }
 
-bool TicTacToe::checkLines(int symbol) {
-    for (int i = 0; i < boardSizeY; ++i) {
-        int rowMatch = 0;
-        int colMatch = 0;
-        for (int j = 0; j < boardSizeX; ++j) {
-            if (board[i][j] == symbol) {
-                if (++rowMatch == matchLength) return true;
-            }
-            else {
-                rowMatch = 0;
-            }
-            if (board[j][i] == symbol) {
-                if (++colMatch == matchLength) return true;
+void TicTacToe::addCandidate(int cell) {
+    if (candidateSlot[cell] >= 0) return;
+    candidateSlot[cell] = static_cast<int>(candidateCells.size());
+    candidateCells.push_back(cell);
+}
+
+void TicTacToe::removeCandidate(int cell) {
+    int slot = candidateSlot[cell];
+    if (slot < 0) return;
+    int last = candidateCells.back();
+    candidateCells[slot] = last;
+    candidateSlot[last] = slot;
+    candidateCells.pop_back();
+    candidateSlot[cell] = -1;
+}
+
+void TicTacToe::updateCandidates(int cell, bool placed) {
+    if (candidateRadius <= 0) return;
+    if (boardKernels && candidateRadius == BoardKernels::CANDIDATE_RADIUS) {
+        boardKernels->updateCandidates(*this, cell, placed);
+        return;
+    }
+
+    int cx = cell % boardSizeX, cy = cell / boardSizeX;
+    int minX = std::max(0, cx - candidateRadius), maxX = std::min(boardSizeX - 1, cx + candidateRadius);
+    int minY = std::max(0, cy - candidateRadius), maxY = std::min(boardSizeY - 1, cy + candidateRadius);
+
+    if (placed) removeCandidate(cell);
+    for (int y = minY; y <= maxY; ++y) {
+        for (int x = minX; x <= maxX; ++x) {
+            int neighbour = y * boardSizeX + x;
+            if (placed) {
+                if (++nearbyStones[neighbour] == 1 && cellAt(x, y) == 0) addCandidate(neighbour);
             }
-            else {
-                colMatch = 0;
+            else if (--nearbyStones[neighbour] == 0) {
+                removeCandidate(neighbour);
             }
         }
     }
-    return false;
+    if (!placed && nearbyStones[cell] > 0) addCandidate(cell);
 }
 
-bool TicTacToe::checkDiagonals(int symbol) {
-    for (int i = 0; i <= boardSizeY - matchLength; ++i) {
-        for (int j = 0; j <= boardSizeX - matchLength; ++j) {
-            int mainDiagMatch = 0;
-            int antiDiagMatch = 0;
-
-            for (int k = 0; k < matchLength; ++k) {
-                if (board[i + k][j + k] == symbol) {
-                    if (++mainDiagMatch == matchLength) return true;
-                }
-                else {
-                    mainDiagMatch = 0;
-                }
+void TicTacToe::rebuildCandidates() {
+    int cells = boardSizeX * boardSizeY;
+    nearbyStones.assign(cells, 0);
+    candidateSlot.assign(cells, -1);
+    candidateCells.clear();
+    candidateCells.reserve(cells);
 
-                if (board[i + k][j + matchLength - k - 1] == symbol) {
-                    if (++antiDiagMatch == matchLength) return true;
-                }
-                else {
-                    antiDiagMatch = 0;
+    for (int c = 0; c < cells; ++c) {
+        if (cellAt(c % boardSizeX, c / boardSizeX) != 0) updateCandidates(c, true);
+    }
+}
+
+void TicTacToe::buildWindows() {
+    static const int directions[4][2] = { {1, 0}, {0, 1}, {1, 1}, {1, -1} };
+    int cells = boardSizeX * boardSizeY;
+    std::vector<int> windowsPerCell(cells, 0);
+
+    windowCells.clear();
+    for (const auto& dir : directions) {
+        for (int y = 0; y < boardSizeY; ++y) {
+            for (int x = 0; x < boardSizeX; ++x) {
+                int endX = x + (matchLength - 1) * dir[0];
+                int endY = y + (matchLength - 1) * dir[1];
+                if (endX < 0 || endY < 0 || endX >= boardSizeX || endY >= boardSizeY) continue;
+
+                for (int k = 0; k < matchLength; ++k) {
+                    int cell = (y + k * dir[1]) * boardSizeX + (x + k * dir[0]);
+                    windowCells.push_back(cell);
+                    windowsPerCell[cell]++;
                 }
             }
         }
     }
-    return false;
+    windowCount = static_cast<int>(windowCells.size()) / matchLength;
+
+    cellWindowStart.assign(cells + 1, 0);
+    for (int c = 0; c < cells; ++c) {
+        cellWindowStart[c + 1] = cellWindowStart[c] + windowsPerCell[c];
+    }
+    cellWindows.assign(cellWindowStart[cells], 0);
+    std::vector<int> filled(cellWindowStart.begin(), cellWindowStart.end() - 1);
+    for (int w = 0; w < windowCount; ++w) {
+        for (int k = 0; k < matchLength; ++k) {
+            int cell = windowCells[w * matchLength + k];
+            cellWindows[filled[cell]++] = w;
+        }
+    }
+}
+
+void TicTacToe::adjustOpenWindows(int playerIndex, int stones, int delta) {
+    openWindows[playerIndex][stones] += delta;
+    if (stones < matchLength) potentialWindows[playerIndex] += delta;
+}
+
+bool TicTacToe::updateWindows(int cell, int player, bool placed) {
+    if (boardKernels) return boardKernels->updateWindows(*this, cell, player, placed);
+
+    int own = player - 1;
+    int other = 1 - own;
+    bool completed = false;
+
+    for (int i = cellWindowStart[cell]; i < cellWindowStart[cell + 1]; ++i) {
+        int w = cellWindows[i];
+        int ownStones = windowStones[own][w];
+        int otherStones = windowStones[other][w];
+
+        if (placed) {
+            if (otherStones == 0) {
+                adjustOpenWindows(own, ownStones, -1);
+                adjustOpenWindows(own, ownStones + 1, 1);
+                completed |= ownStones + 1 == matchLength;
+            }
+            if (ownStones == 0) adjustOpenWindows(other, otherStones, -1);
+            windowStones[own][w] = ownStones + 1;
+        }
+        else {
+            if (otherStones == 0) {
+                adjustOpenWindows(own, ownStones, -1);
+                adjustOpenWindows(own, ownStones - 1, 1);
+            }
+            if (ownStones == 1) adjustOpenWindows(other, otherStones, 1);
+            windowStones[own][w] = ownStones - 1;
+        }
+    }
+    return completed;
+}
+
+int TicTacToe::cellAt(int x, int y) const {
+    int bit = stones[0].index(x, y);
+    if (stones[1].test(bit)) return 2;
+    if (stones[0].test(bit)) return 1;
+    return 0;
+}
+
+bool TicTacToe::checkLines(int symbol) {
+    const Bitboard& own = stones[symbol - 1];
+    return own.hasRun(lineSteps[0], matchLength) || own.hasRun(lineSteps[1], matchLength);
+}
+
+bool TicTacToe::checkDiagonals(int symbol) {
+    const Bitboard& own = stones[symbol - 1];
+    return own.hasRun(lineSteps[2], matchLength) || own.hasRun(lineSteps[3], matchLength);
 }
 
 void TicTacToe::checkGameState() {
-    if (checkLines(2) || checkDiagonals(2)) {
+    // makeMove keeps the winner up to date, so no board scan is needed here
+    if (winnerPlayer == 2) {
         isGameOver = true;
         winner = "X";
     }
-    else if (checkLines(1) || checkDiagonals(1)) {
+    else if (winnerPlayer == 1) {
         isGameOver = true;
         winner = "O";
     }
-    else {
-        int emptyCells = boardSizeX * boardSizeY;
-        for (const auto& row : board) {
-            emptyCells -= static_cast<int>(std::count(row.begin(), row.end(), 0));
-        }
-        if (emptyCells == 0) {
-            isDraw = true;
-            isGameOver = true;
-        }
+    else if (stoneCount == boardSizeX * boardSizeY) {
+        isDraw = true;
+        isGameOver = true;
     }
 }
 
@@ -80,7 +191,13 @@ void TicTacToe::reset() {
     isOTurn = (false);
     isPositionInvalid = (false);
     isDraw = (false);
-    previousMoves = std::vector<std::pair<int, int>>();
+    winner = "";
+    moveNumber = 0;
+    std::fill(std::begin(boardHashes), std::end(boardHashes), 0ULL);
+    stoneCount = 0;
+    winnerPlayer = 0;
+    winPly = -1;
+    previousMoves.clear();
     checkGameState();
 }
 
@@ -89,31 +206,35 @@ bool TicTacToe::move(int x, int y) {
         std::cerr << "Game is already over\n";
         return false;
     }
-    if (x < 1 || x > boardSizeX || y < 1 || y > boardSizeY || board[y - 1][x - 1] != 0) {
+    if (x < 1 || x > boardSizeX || y < 1 || y > boardSizeY || cellAt(x - 1, y - 1) != 0) {
         std::cerr << "Invalid move\n";
         return false;
     }
 
+    commitMove(x, y);
+    return true;
+}
+
+void TicTacToe::commitMove(int x, int y) {
     makeMove(x, y, isXTurn ? 2 : 1);
     isXTurn = !isXTurn;
     isOTurn = !isOTurn;
     previousMoves.push_back({ x, y });
     if (isXTurn) moveNumber++;
-    updateHash(x, y, isXTurn ? 1 : 2);
     checkGameState();
-    return true;
 }
 
 std::string TicTacToe::ascii() const {
     std::string asciiBoard = "";
-    for (size_t i = 0; i < board.size(); ++i) {
+    for (int i = 0; i < boardSizeY; ++i) {
         asciiBoard += "|";
-        for (size_t j = 0; j < board[i].size(); ++j) {
-            asciiBoard += (board[i][j] == 0 ? ' ' : (board[i][j] == 1 ? 'O' : 'X'));
-            if (j < board[i].size() - 1) asciiBoard += "|";
+        for (int j = 0; j < boardSizeX; ++j) {
+            int cell = cellAt(j, i);
+            asciiBoard += (cell == 0 ? ' ' : (cell == 1 ? 'O' : 'X'));
+            if (j < boardSizeX - 1) asciiBoard += "|";
         }
-        if (i < board.size() - 1) {
-            asciiBoard += "|\n" + std::string(board[i].size() * 2 - 1, '-') + "\n";
+        if (i < boardSizeY - 1) {
+            asciiBoard += "|\n" + std::string(boardSizeX * 2 - 1, '-') + "\n";
         }
     }
     return asciiBoard;
@@ -148,4 +269,164 @@ std::string TicTacToe::getResult() {
         result += " 1/2-1/2";
     }
     return result;
-}
\ No newline at end of file
+}
+
+bool TicTacToe::writeRecord(GameRecordWriter& writer, std::string* error) const {
+    GameRecord::Result result = GameRecord::UNFINISHED;
+    if (isDraw) result = GameRecord::DRAW;
+    else if (winner == "X") result = GameRecord::X_WINS;
+    else if (winner == "O") result = GameRecord::O_WINS;
+    return writer.writeGame(boardSizeX, boardSizeY, matchLength, previousMoves, result, error);
+}
+
+static bool loadFailed(std::string* error, const std::string& reason) {
+    if (error) *error = reason;
+    return false;
+}
+
+bool TicTacToe::replayMove(int x, int y, std::string* error) {
+    bool onBoard = x >= 1 && x <= boardSizeX && y >= 1 && y <= boardSizeY;
+    if (isGameOver || !onBoard || cellAt(x - 1, y - 1) != 0) {
+        return loadFailed(error, "Move " + std::to_string(previousMoves.size() + 1) + " (" + std::to_string(x) + "-"
+            + std::to_string(y) + ") " + (isGameOver ? "comes after the game is over" : "is illegal"));
+    }
+    commitMove(x, y);
+    return true;
+}
+
+bool TicTacToe::checkRecordedResult(GameRecord::Result result, std::string* error) const {
+    // getResult writes 1/2-1/2 for a game still in progress, so a draw only rules out a winner
+    bool consistent = result == GameRecord::UNFINISHED
+        || (result == GameRecord::X_WINS && winnerPlayer == 2)
+        || (result == GameRecord::O_WINS && winnerPlayer == 1)
+        || (result == GameRecord::DRAW && winnerPlayer == 0);
+    return consistent || loadFailed(error, "The stated result does not match the game");
+}
+
+bool TicTacToe::loadRecord(const GameRecord& record, std::string* error) {
+    if (record.width != boardSizeX || record.height != boardSizeY || record.matchLength != matchLength) {
+        return loadFailed(error, "Game record is for a " + std::to_string(record.width) + "x" + std::to_string(record.height)
+            + "/" + std::to_string(record.matchLength) + " board");
+    }
+    reset();
+    for (const auto& recorded : record) {
+        if (!replayMove(recorded.first, recorded.second, error)) {
+            reset();
+            return false;
+        }
+    }
+    if (!checkRecordedResult(record.result, error)) {
+        reset();
+        return false;
+    }
+    return true;
+}
+
+bool TicTacToe::loadMoves(const std::vector<std::pair<int, int>>& moves, std::string* error) {
+    reset();
+    for (const auto& move : moves) {
+        if (!replayMove(move.first, move.second, error)) {
+            reset();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TicTacToe::loadPosition(const std::string& position, std::string* error) {
+    ParsedPosition parsed;
+    const char* cursor = position.data();
+    if (!Notation::parsePosition(cursor, cursor + position.size(), parsed, error)) return false;
+    return loadPosition(parsed, error);
+}
+
+bool TicTacToe::loadPosition(const ParsedPosition& position, std::string* error) {
+    if (position.width != boardSizeX || position.height != boardSizeY || position.matchLength != matchLength) {
+        return loadFailed(error, "Position is for a " + std::to_string(position.width) + "x" + std::to_string(position.height)
+            + "/" + std::to_string(position.matchLength) + " board");
+    }
+
+    int counts[3] = { 0, 0, 0 };
+    for (uint8_t cell : position.cells) counts[cell]++;
+    int xStones = counts[2], oStones = counts[1];
+    if (xStones != oStones && xStones != oStones + 1) {
+        return loadFailed(error, "Invalid position: X has " + std::to_string(xStones) + " stones and O has "
+            + std::to_string(oStones));
+    }
+    if (position.xToMove != (xStones == oStones)) return loadFailed(error, "Invalid position: wrong side to move");
+
+    // Stones go straight onto the board; the incremental state follows as usual
+    reset();
+    for (int cell = 0; cell < boardSizeX * boardSizeY; ++cell) {
+        if (position.cells[cell]) makeMove(cell % boardSizeX + 1, cell / boardSizeX + 1, position.cells[cell]);
+    }
+
+    // makeMove credits whichever line it completed first, so settle the winner from the whole board
+    bool xLine = checkLines(2) || checkDiagonals(2);
+    bool oLine = checkLines(1) || checkDiagonals(1);
+    if ((xLine && oLine) || (xLine && position.xToMove) || (oLine && !position.xToMove)) {
+        reset();
+        return loadFailed(error, "Invalid position: the side to move already has a line, or both sides do");
+    }
+    winnerPlayer = xLine ? 2 : (oLine ? 1 : 0);
+
+    if (winnerPlayer) {
+        // One move finished the game, so every full window of the winner shares its stone
+        const std::vector<int>& stonesInWindow = windowStones[winnerPlayer - 1];
+        std::vector<int> shared;
+        bool first = true;
+        for (int w = 0; w < windowCount; ++w) {
+            if (stonesInWindow[w] != matchLength) continue;
+            const int* cells = &windowCells[w * matchLength];
+            if (first) shared.assign(cells, cells + matchLength);
+            else {
+                shared.erase(std::remove_if(shared.begin(), shared.end(), [&](int cell) {
+                    return std::find(cells, cells + matchLength, cell) == cells + matchLength;
+                }), shared.end());
+            }
+            first = false;
+        }
+        if (shared.empty()) {
+            reset();
+            return loadFailed(error, "Invalid position: the winner has lines that no single move could have finished");
+        }
+    }
+    winPly = winnerPlayer ? stoneCount : -1;
+
+    isXTurn = position.xToMove;
+    isOTurn = !isXTurn;
+    moveNumber = oStones;
+    checkGameState();
+    return true;
+}
+
+std::string TicTacToe::getPosition() const {
+    ParsedPosition position;
+    position.width = boardSizeX;
+    position.height = boardSizeY;
+    position.matchLength = matchLength;
+    position.xToMove = isXTurn;
+    position.cells.resize(boardSizeX * boardSizeY);
+    for (int cell = 0; cell < boardSizeX * boardSizeY; ++cell) {
+        position.cells[cell] = static_cast<uint8_t>(cellAt(cell % boardSizeX, cell / boardSizeX));
+    }
+    return Notation::formatPosition(position);
+}
+
+bool TicTacToe::loadGame(const std::string& text, std::string* error) {
+    std::vector<std::pair<int, int>> moves;
+    GameRecord::Result result;
+    if (!GameRecord::parseText(text, moves, result, error)) return false;
+    reset();
+    for (const auto& played : moves) {
+        if (!replayMove(played.first, played.second, error)) {
+            reset();
+            return false;
+        }
+    }
+    if (!checkRecordedResult(result, error)) {
+        reset();
+        return false;
+    }
+    return true;
+}
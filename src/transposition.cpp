@@ -0,0 +1,96 @@
+#include "../include/transposition.h"
+
+// Packed layout: score in bits 0-31, depth in 32-39, bound in 40-41,
+// generation in 42-47, move + 1 in 48-62, bit 63 marks the slot as used.
+static constexpr uint64_t USED_BIT = 1ULL << 63;
+static constexpr int MOVE_LIMIT = (1 << 15) - 1;
+
+uint64_t TranspositionTable::pack(const TTEntry& entry, uint64_t generation) {
+    uint64_t depth = static_cast<uint64_t>(entry.depth < 0 ? 0 : (entry.depth > 255 ? 255 : entry.depth));
+    uint64_t move = (entry.move >= 0 && entry.move < MOVE_LIMIT) ? entry.move + 1 : 0;
+    return static_cast<uint32_t>(entry.score)
+        | (depth << 32)
+        | (static_cast<uint64_t>(entry.flag) << 40)
+        | ((generation & 63) << 42)
+        | (move << 48)
+        | USED_BIT;
+}
+
+TTEntry TranspositionTable::unpack(uint64_t data) {
+    TTEntry entry;
+    entry.score = static_cast<int32_t>(static_cast<uint32_t>(data));
+    entry.depth = depthOf(data);
+    entry.flag = static_cast<TTEntry::BoundType>((data >> 40) & 3);
+    entry.move = static_cast<int>((data >> 48) & MOVE_LIMIT) - 1;
+    return entry;
+}
+
+int TranspositionTable::depthOf(uint64_t data) {
+    return static_cast<int>((data >> 32) & 255);
+}
+
+uint64_t TranspositionTable::generationOf(uint64_t data) {
+    return (data >> 42) & 63;
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    size_t bytes = megabytes * 1024 * 1024;
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= bytes) {
+        count *= 2;
+    }
+    buckets.reset(new Bucket[count]());  // value-initialized, so already empty
+    bucketCount = count;
+    generation = 0;
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < bucketCount; ++i) {
+        for (Slot& slot : buckets[i].slots) {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+void TranspositionTable::newSearch() {
+    generation = (generation + 1) & 63;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    const Bucket& bucket = buckets[key & (bucketCount - 1)];
+    for (const Slot& slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((data & USED_BIT) && (check ^ data) == key) {
+            entry = unpack(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, const TTEntry& entry) {
+    Bucket& bucket = buckets[key & (bucketCount - 1)];
+    uint64_t data = pack(entry, generation);
+
+    // The first slot is only given up for the same position, an equal or deeper
+    // result, or an entry left over from an earlier search
+    Slot& preferred = bucket.slots[0];
+    uint64_t oldData = preferred.data.load(std::memory_order_relaxed);
+    uint64_t oldKey = preferred.check.load(std::memory_order_relaxed) ^ oldData;
+    Slot& target = (!(oldData & USED_BIT) || oldKey == key || entry.depth >= depthOf(oldData)
+        || generationOf(oldData) != generation) ? preferred : bucket.slots[1];
+
+    target.check.store(key ^ data, std::memory_order_relaxed);
+    target.data.store(data, std::memory_order_relaxed);
+}
+
+size_t TranspositionTable::sizeInBytes() const {
+    return bucketCount * sizeof(Bucket);
+}
@@ -0,0 +1,58 @@
+#include "../include/zobrist.h"
+#include <map>
+#include <mutex>
+#include <random>
+
+static constexpr uint64_t ZOBRIST_SEED = 0x9E3779B97F4A7C15ULL;
+
+ZobristKeys::ZobristKeys(int width, int height)
+    : cells(width * height), symmetries(width == height ? 8 : 4) {
+    std::vector<uint64_t> base(static_cast<size_t>(cells) * 2);
+    std::mt19937_64 rng(ZOBRIST_SEED);
+    for (auto& key : base) {
+        key = rng();
+    }
+    side = rng();
+
+    cellMaps.resize(static_cast<size_t>(symmetries) * cells);
+    inverseMaps.resize(cellMaps.size());
+    keys.resize(static_cast<size_t>(symmetries) * cells * 2);
+
+    for (int t = 0; t < symmetries; ++t) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                int tx = x, ty = y;
+                switch (t) {
+                case 1: tx = width - 1 - x; break;
+                case 2: ty = height - 1 - y; break;
+                case 3: tx = width - 1 - x; ty = height - 1 - y; break;
+                case 4: tx = y; ty = x; break;
+                case 5: tx = width - 1 - y; ty = x; break;
+                case 6: tx = y; ty = height - 1 - x; break;
+                case 7: tx = width - 1 - y; ty = height - 1 - x; break;
+                }
+                int cell = y * width + x;
+                int mapped = ty * width + tx;
+                cellMaps[t * cells + cell] = mapped;
+                inverseMaps[t * cells + mapped] = cell;
+                for (int p = 0; p < 2; ++p) {
+                    keys[(static_cast<size_t>(t) * cells + cell) * 2 + p] = base[mapped * 2 + p];
+                }
+            }
+        }
+    }
+}
+
+std::shared_ptr<const ZobristKeys> ZobristKeys::forBoard(int width, int height) {
+    static std::mutex cacheMutex;
+    static std::map<std::pair<int, int>, std::weak_ptr<const ZobristKeys>> cache;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto& slot = cache[{ width, height }];
+    std::shared_ptr<const ZobristKeys> keys = slot.lock();
+    if (!keys) {
+        keys = std::make_shared<const ZobristKeys>(width, height);
+        slot = keys;
+    }
+    return keys;
+}
@@ -0,0 +1,384 @@
+// Microbenchmarks for the engine primitives plus correctness checks for the search.
+//
+// Usage: bench [--min-time MS] [--filter NAME]
+// Every primitive is timed on a set of mid-game positions for each board in BOARDS and
+// reported as ns/op. Boards with compiled kernels (board_kernels.h) are timed twice, the
+// second time on the runtime loops, so the two can be compared on the same positions.
+//
+// The "search threads" line runs the same fixed-depth searches with one thread and with
+// several and reports node rate and total time for each; it never fails the run.
+//
+// The rest are checks, and any failure fails the run:
+// - perft: the known 3x3 game count must come out exactly.
+// - allocations: a getBestMove after the engine has searched once must not allocate.
+// - game record: a varint too long for 32 bits must be rejected rather than wrapped.
+// - warm table: searching a position for the wrong side first must not change the
+//   answer for the right side.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../include/board_kernels.h"
+#include "../../include/game_record.h"
+#include "../../include/line_kernels.h"
+#include "../../include/tictactoe.h"
+
+struct BoardConfig {
+    int width;
+    int height;
+    int matchLength;
+};
+
+static const BoardConfig BOARDS[] = {
+    { 3, 3, 3 }, { 5, 5, 4 }, { 7, 7, 4 }, { 9, 9, 5 }, { 15, 15, 5 }, { 19, 19, 5 }, { 19, 19, 6 },
+};
+
+static const int POSITIONS_PER_BOARD = 8;
+static volatile long long sink = 0;  // keeps results alive so the calls are not optimized out
+static std::atomic<unsigned long long> allocationCount(0);  // every operator new in the process
+
+void* operator new(std::size_t size) {
+    allocationCount++;
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+// Reaches into TicTacToe's private members; declared a friend in tictactoe.h
+class EngineBenchmark {
+public:
+    // Random position with about a third of the board filled and no finished line
+    static void fillRandom(TicTacToe& game, std::mt19937& random) {
+        int cells = game.boardSizeX * game.boardSizeY;
+        int target = cells / 3;
+        int player = 2;
+        for (int attempts = 0; game.stoneCount < target && attempts < cells * 4; ++attempts) {
+            int x = static_cast<int>(random() % game.boardSizeX) + 1;
+            int y = static_cast<int>(random() % game.boardSizeY) + 1;
+            if (game.cellAt(x - 1, y - 1) != 0 || game.isWinningMove(x, y, player)) continue;
+            game.makeMove(x, y, player);
+            player = 3 - player;
+        }
+    }
+
+    // A few random moves from the empty board, none of them finishing a line
+    static void playRandom(TicTacToe& game, std::mt19937& random, int plies) {
+        int player = 2;
+        while (game.stoneCount < plies) {
+            int x = static_cast<int>(random() % game.boardSizeX) + 1;
+            int y = static_cast<int>(random() % game.boardSizeY) + 1;
+            if (game.cellAt(x - 1, y - 1) != 0 || game.isWinningMove(x, y, player)) continue;
+            game.makeMove(x, y, player);
+            player = 3 - player;
+        }
+    }
+
+    static std::pair<int, int> emptyCell(TicTacToe& game, std::mt19937& random) {
+        while (true) {
+            int x = static_cast<int>(random() % game.boardSizeX) + 1;
+            int y = static_cast<int>(random() % game.boardSizeY) + 1;
+            if (game.cellAt(x - 1, y - 1) == 0) return { x, y };
+        }
+    }
+
+    static int sideToMove(const TicTacToe& game) { return game.stoneCount % 2 == 0 ? 2 : 1; }
+
+    static void useRuntimeGeometry(TicTacToe& game) { game.boardKernels = nullptr; }
+
+    static bool isWinningMove(TicTacToe& game, const std::pair<int, int>& move, int player) {
+        return game.isWinningMove(move.first, move.second, player);
+    }
+
+    static bool checkLines(TicTacToe& game, int player) { return game.checkLines(player); }
+
+    static bool checkDiagonals(TicTacToe& game, int player) { return game.checkDiagonals(player); }
+
+    static int countLines(TicTacToe& game, int player) { return game.countLines(player, game.matchLength - 1); }
+
+    static int countPotentialWinningLines(TicTacToe& game, int player) { return game.countPotentialWinningLines(player); }
+
+    static int scoreMove(TicTacToe& game, const std::pair<int, int>& move, int player) { return game.scoreMove(move, player); }
+
+    static int evaluatePosition(TicTacToe& game) { return game.evaluatePosition(true); }
+
+    static void makeMove(TicTacToe& game, const std::pair<int, int>& move, int player) {
+        game.makeMove(move.first, move.second, player);
+    }
+
+    static void makeUndo(TicTacToe& game, const std::pair<int, int>& move, int player) {
+        game.makeMove(move.first, move.second, player);
+        game.undoMove(move.first, move.second);
+    }
+
+};
+
+struct Fixture {
+    TicTacToe game;
+    std::pair<int, int> move;  // an empty cell
+    int player;
+};
+
+// Runs op over the fixtures until minTime has passed and returns ns per call
+static double timeOperation(std::vector<Fixture>& fixtures, const std::function<long long(Fixture&)>& op, double minSeconds) {
+    unsigned long long calls = 0;
+    long long total = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        for (int repeat = 0; repeat < 64; ++repeat) {
+            for (auto& fixture : fixtures) {
+                total += op(fixture);
+            }
+        }
+        calls += 64 * fixtures.size();
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    sink = sink + total;
+    return elapsed * 1e9 / calls;
+}
+
+static bool runPerft(const BoardConfig& board, int depth, unsigned long long expected) {
+    TicTacToe game(board.width, board.height, board.matchLength);
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long leaves = game.perft(depth);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool ok = expected == 0 || leaves == expected;
+    std::cout << "perft " << board.width << "x" << board.height << "/" << board.matchLength
+        << " depth " << depth << ": " << leaves << " leaves, "
+        << std::fixed << std::setprecision(2) << leaves / seconds / 1e6 << " M leaves/s"
+        << (expected == 0 ? "" : (ok ? "  [ok]" : "  [MISMATCH, expected " + std::to_string(expected) + "]")) << '\n';
+    return ok;
+}
+
+// Heap allocations made by a whole getBestMove, root and threat search included. The first
+// search allocates the transposition table and sizes the scratch buffers, so it only warms
+// the engine up; the count is taken on the search after the next move. Positions are only
+// a few moves in, so the search is not cut short by a forced move or a threat sequence.
+static bool runAllocationCheck(const BoardConfig& board, int depth, std::mt19937& random) {
+    SearchLimits limits;
+    limits.maxDepth = depth;
+    int plies = std::min(8, board.width * board.height / 4);
+    for (int attempt = 0; attempt < 20; ++attempt) {
+        TicTacToe game(board.width, board.height, board.matchLength);
+        EngineBenchmark::playRandom(game, random, plies);
+        int player = EngineBenchmark::sideToMove(game);
+        game.getBestMove(limits, player == 2);
+        if (game.getSearchStats().reason != "Search") continue;
+
+        auto move = EngineBenchmark::emptyCell(game, random);
+        if (EngineBenchmark::isWinningMove(game, move, player)) continue;
+        EngineBenchmark::makeMove(game, move, player);
+        unsigned long long before = allocationCount;
+        game.getBestMove(limits, player != 2);
+        unsigned long long allocations = allocationCount - before;
+        if (game.getSearchStats().reason != "Search") continue;
+
+        std::cout << "getBestMove allocations " << board.width << "x" << board.height << "/" << board.matchLength
+            << " depth " << depth << ": " << allocations << (allocations == 0 ? "  [ok]" : "  [FAILED]") << '\n';
+        return allocations == 0;
+    }
+    std::cout << "getBestMove allocations " << board.width << "x" << board.height << "/" << board.matchLength
+        << " depth " << depth << ": no quiet position found  [FAILED]\n";
+    return false;
+}
+
+// Root splitting can search more nodes than one thread would, so the total time to reach the
+// depth is the number that matters; the node rate alone can flatter the threads
+static void runThreadScaling(const BoardConfig& board, int depth, int threads, int positions, std::mt19937& random) {
+    SearchLimits limits;
+    limits.maxDepth = depth;
+    unsigned long long nodes[2] = { 0, 0 };
+    double seconds[2] = { 0, 0 };
+    int searched = 0, differ = 0;
+    for (int attempt = 0; searched < positions && attempt < positions * 4; ++attempt) {
+        TicTacToe position(board.width, board.height, board.matchLength);
+        EngineBenchmark::playRandom(position, random, 8);
+        bool isMaximizing = EngineBenchmark::sideToMove(position) == 2;
+
+        std::pair<int, int> moves[2];
+        bool quiet = true;
+        for (int run = 0; run < 2 && quiet; ++run) {
+            TicTacToe game = position;
+            game.setSearchThreads(run == 0 ? 1 : threads);
+            moves[run] = game.getBestMove(limits, isMaximizing);
+            const SearchStats& stats = game.getSearchStats();
+            quiet = stats.reason == "Search";
+            nodes[run] += stats.nodes;
+            seconds[run] += stats.seconds;
+        }
+        if (!quiet) continue;
+        searched++;
+        if (moves[0] != moves[1]) differ++;
+    }
+
+    std::cout << "search threads " << board.width << "x" << board.height << "/" << board.matchLength
+        << " depth " << depth << ", " << searched << " positions: " << std::fixed << std::setprecision(2)
+        << "1 thread " << nodes[0] / std::max(seconds[0], 1e-9) / 1e6 << " M nodes/s in " << seconds[0] << " s, "
+        << threads << " threads " << nodes[1] / std::max(seconds[1], 1e-9) / 1e6 << " M nodes/s in " << seconds[1] << " s, "
+        << differ << " best moves differ\n";
+}
+
+// Two 3x3 records with no moves: the first well formed, the second with its width written
+// as a five-byte varint whose top bits do not fit in 32 bits (3 + 2^32, which would wrap to 3)
+static bool runGameRecordCheck() {
+    const unsigned char bytes[] = {
+        'T', 'T', 'G', 'R', 1, 0, 0, 0,
+        3, 3, 3, 0, GameRecord::DRAW,
+        0x83, 0x80, 0x80, 0x80, 0x10, 3, 3, 0, GameRecord::DRAW,
+    };
+    std::string path = (std::filesystem::temp_directory_path() / "bench_overlong_varint.ttgr").string();
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    }
+
+    GameRecordReader reader;
+    GameRecord record;
+    bool first = reader.open(path) && reader.next(record) && record.width == 3;
+    bool overlong = first && reader.next(record);
+    reader.close();
+    std::remove(path.c_str());
+
+    bool ok = first && !overlong;
+    std::cout << "game record overlong varint: " << (!first ? "valid record not read" : overlong ? "accepted" : "rejected")
+        << (ok ? "  [ok]" : "  [FAILED]") << '\n';
+    return ok;
+}
+
+// A transposition table left over from searching the other side must not change the
+// result: each position is searched for the wrong side first, then for the side to move,
+// and the answer has to match a fresh engine's
+static bool runWarmTableCheck(const BoardConfig& board, int depth, int positions, std::mt19937& random) {
+    SearchLimits limits;
+    limits.maxDepth = depth;
+    int mismatches = 0;
+    for (int i = 0; i < positions; ++i) {
+        TicTacToe warm(board.width, board.height, board.matchLength);
+        EngineBenchmark::playRandom(warm, random, 6);
+        TicTacToe cold = warm;  // copied before the first search, so it gets its own table
+        bool isMaximizing = EngineBenchmark::sideToMove(warm) == 2;
+
+        warm.getBestMove(limits, !isMaximizing);
+        auto warmMove = warm.getBestMove(limits, isMaximizing);
+        auto coldMove = cold.getBestMove(limits, isMaximizing);
+        const auto& warmIterations = warm.getSearchStats().iterations;
+        const auto& coldIterations = cold.getSearchStats().iterations;
+        int warmScore = warmIterations.empty() ? 0 : warmIterations.back().score;
+        int coldScore = coldIterations.empty() ? 0 : coldIterations.back().score;
+        if (warmMove != coldMove || warmScore != coldScore) mismatches++;
+    }
+
+    std::cout << "warm table " << board.width << "x" << board.height << "/" << board.matchLength
+        << " depth " << depth << ": " << mismatches << " of " << positions << " positions differ"
+        << (mismatches == 0 ? "  [ok]" : "  [FAILED]") << '\n';
+    return mismatches == 0;
+}
+
+int main(int argc, char** argv) {
+    double minSeconds = 0.2;
+    std::string filter;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--min-time") minSeconds = std::atof(argv[i + 1]) / 1000.0;
+        else if (arg == "--filter") filter = argv[i + 1];
+    }
+
+    using Op = std::function<long long(Fixture&)>;
+    const std::vector<std::pair<std::string, Op>> operations = {
+        { "checkLines", [](Fixture& f) { return (long long)EngineBenchmark::checkLines(f.game, f.player); } },
+        { "checkDiagonals", [](Fixture& f) { return (long long)EngineBenchmark::checkDiagonals(f.game, f.player); } },
+        { "countLines", [](Fixture& f) { return (long long)EngineBenchmark::countLines(f.game, f.player); } },
+        { "isWinningMove", [](Fixture& f) { return (long long)EngineBenchmark::isWinningMove(f.game, f.move, f.player); } },
+        { "countPotentialWinningLines", [](Fixture& f) { return (long long)EngineBenchmark::countPotentialWinningLines(f.game, f.player); } },
+        { "scoreMove", [](Fixture& f) { return (long long)EngineBenchmark::scoreMove(f.game, f.move, f.player); } },
+        { "evaluatePosition", [](Fixture& f) { return (long long)EngineBenchmark::evaluatePosition(f.game); } },
+        { "makeMove+undoMove", [](Fixture& f) { EngineBenchmark::makeUndo(f.game, f.move, f.player); return 0LL; } },
+    };
+
+    std::mt19937 random(12345);
+    std::cout << "line kernels: " << LineKernels::active().name << "\n";
+    std::cout << std::left << std::setw(28) << "primitive" << std::setw(18) << "board" << "ns/op\n";
+    for (const auto& board : BOARDS) {
+        std::vector<Fixture> fixtures;
+        for (int i = 0; i < POSITIONS_PER_BOARD; ++i) {
+            Fixture fixture{ TicTacToe(board.width, board.height, board.matchLength), { 0, 0 }, 0 };
+            EngineBenchmark::fillRandom(fixture.game, random);
+            fixture.move = EngineBenchmark::emptyCell(fixture.game, random);
+            fixture.player = EngineBenchmark::sideToMove(fixture.game);
+            fixtures.push_back(std::move(fixture));
+        }
+
+        std::string name = std::to_string(board.width) + "x" + std::to_string(board.height) + "/" + std::to_string(board.matchLength);
+        bool compiled = BoardKernels::forBoard(board.width, board.height, board.matchLength) != nullptr;
+        for (int pass = 0; pass < (compiled ? 2 : 1); ++pass) {
+            if (pass == 1) {
+                for (auto& fixture : fixtures) EngineBenchmark::useRuntimeGeometry(fixture.game);
+            }
+            std::string label = name + (compiled ? (pass == 0 ? " compiled" : " runtime") : "");
+            for (const auto& operation : operations) {
+                if (!filter.empty() && operation.first.find(filter) == std::string::npos) continue;
+                double ns = timeOperation(fixtures, operation.second, minSeconds);
+                std::cout << std::left << std::setw(28) << operation.first << std::setw(18) << label
+                    << std::fixed << std::setprecision(1) << ns << '\n';
+            }
+        }
+    }
+
+    if (filter.empty() || std::string("threads").find(filter) != std::string::npos) {
+        int threads = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+        runThreadScaling({ 15, 15, 5 }, 5, threads, 4, random);
+    }
+
+    bool ok = true;
+    if (filter.empty() || std::string("perft").find(filter) != std::string::npos) {
+        ok &= runPerft({ 3, 3, 3 }, 9, 255168);
+        ok &= runPerft({ 4, 4, 3 }, 6, 0);
+        ok &= runPerft({ 5, 5, 4 }, 5, 0);
+        ok &= runPerft({ 9, 9, 5 }, 4, 81ULL * 80 * 79 * 78);
+    }
+    if (filter.empty() || std::string("allocations").find(filter) != std::string::npos) {
+        ok &= runAllocationCheck({ 3, 3, 3 }, 9, random);
+        ok &= runAllocationCheck({ 9, 9, 5 }, 5, random);
+        ok &= runAllocationCheck({ 15, 15, 5 }, 4, random);
+        ok &= runAllocationCheck({ 19, 19, 6 }, 4, random);
+    }
+    if (filter.empty() || std::string("game record").find(filter) != std::string::npos) {
+        ok &= runGameRecordCheck();
+    }
+    if (filter.empty() || std::string("warm table").find(filter) != std::string::npos) {
+        ok &= runWarmTableCheck({ 7, 7, 4 }, 4, 30, random);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+// Self-play harness: plays games between two engine configurations on a thread pool
+// and prints throughput, per-move latency and results as JSON.
+//
+// Usage: selfplay [--games N] [--threads T] [--size WxH] [--match K] [--hash MB]
+//                 [--random-plies R] [--seed S] [--output FILE] [--record FILE]
+//                 [--depth-a D] [--time-a MS] [--nodes-a N]
+//                 [--depth-b D] [--time-b MS] [--nodes-b N]
+// Engine A plays X in even-numbered games and O in odd ones. The first R plies of each
+// game are random (seeded per game) so that the deterministic engines do not replay
+// the same game over and over. The JSON report goes to stdout, or to FILE if given.
+// --record appends every finished game to a binary game record file (see game_record.h).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include "../../include/thread_pool.h"
+#include "../../include/tictactoe.h"
+
+struct EngineConfig {
+    int depth = 4;
+    int moveTimeMs = 0;
+    unsigned long long maxNodes = 0;
+
+    SearchLimits limits() const {
+        SearchLimits limits = moveTimeMs > 0 ? SearchLimits::withMoveTime(std::chrono::milliseconds(moveTimeMs)) : SearchLimits();
+        limits.maxDepth = depth;
+        limits.maxNodes = maxNodes;
+        return limits;
+    }
+
+    std::string json() const {
+        return "{\"depth\": " + std::to_string(depth) + ", \"moveTimeMs\": " + std::to_string(moveTimeMs)
+            + ", \"maxNodes\": " + std::to_string(maxNodes) + "}";
+    }
+};
+
+struct Options {
+    int games = 100;
+    int threads = 0;
+    int width = 9;
+    int height = 9;
+    int matchLength = 5;
+    size_t hashSizeMB = 4;
+    int randomPlies = 2;
+    unsigned seed = 1;
+    std::string output;  // empty for stdout
+    std::string record;  // game record file, empty for none
+    EngineConfig engines[2];
+};
+
+struct Totals {
+    std::vector<double> latenciesMs;
+    unsigned long long nodes = 0;
+    unsigned long long ttProbes = 0;
+    unsigned long long ttHits = 0;
+    unsigned long long betaCutoffs = 0;
+    unsigned long long firstMoveCutoffs = 0;
+    double searchSeconds = 0;
+    int wins[2] = { 0, 0 };  // by engine
+    int draws = 0;
+};
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << '\n';
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--games") options.games = std::atoi(value);
+        else if (arg == "--threads") options.threads = std::atoi(value);
+        else if (arg == "--match") options.matchLength = std::atoi(value);
+        else if (arg == "--hash") options.hashSizeMB = static_cast<size_t>(std::atoi(value));
+        else if (arg == "--random-plies") options.randomPlies = std::atoi(value);
+        else if (arg == "--seed") options.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (arg == "--output") options.output = value;
+        else if (arg == "--record") options.record = value;
+        else if (arg == "--size") {
+            if (std::sscanf(value, "%dx%d", &options.width, &options.height) != 2) {
+                std::cerr << "Expected --size WxH\n";
+                return false;
+            }
+        }
+        else if (arg == "--depth-a") options.engines[0].depth = std::atoi(value);
+        else if (arg == "--time-a") options.engines[0].moveTimeMs = std::atoi(value);
+        else if (arg == "--nodes-a") options.engines[0].maxNodes = std::strtoull(value, nullptr, 10);
+        else if (arg == "--depth-b") options.engines[1].depth = std::atoi(value);
+        else if (arg == "--time-b") options.engines[1].moveTimeMs = std::atoi(value);
+        else if (arg == "--nodes-b") options.engines[1].maxNodes = std::strtoull(value, nullptr, 10);
+        else {
+            std::cerr << "Unknown option " << arg << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+// Both engines follow the game on their own board; returns the winning engine, or -1 for a draw
+static int playGame(int gameIndex, const Options& options, TicTacToe* engines[2], Totals& totals) {
+    for (int e = 0; e < 2; ++e) {
+        engines[e]->reset();
+        engines[e]->clearHash();
+    }
+    TicTacToe& board = *engines[0];
+    std::mt19937 random(options.seed + gameIndex);
+    std::vector<bool> occupied(options.width * options.height, false);
+
+    int xEngine = gameIndex % 2;
+    for (int ply = 0; !board.isOver(); ++ply) {
+        std::pair<int, int> move;
+        if (ply < options.randomPlies) {
+            do {
+                move = { static_cast<int>(random() % options.width) + 1, static_cast<int>(random() % options.height) + 1 };
+            } while (occupied[(move.second - 1) * options.width + move.first - 1]);
+        }
+        else {
+            int mover = board.isXTurn ? xEngine : 1 - xEngine;
+            auto start = std::chrono::steady_clock::now();
+            move = engines[mover]->getBestMove(options.engines[mover].limits(), board.isXTurn);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            totals.latenciesMs.push_back(seconds * 1000.0);
+            totals.searchSeconds += seconds;
+            const SearchStats& stats = engines[mover]->getSearchStats();
+            totals.nodes += stats.nodes;
+            totals.ttProbes += stats.ttProbes;
+            totals.ttHits += stats.ttHits;
+            totals.betaCutoffs += stats.betaCutoffs;
+            totals.firstMoveCutoffs += stats.firstMoveCutoffs;
+        }
+        occupied[(move.second - 1) * options.width + move.first - 1] = true;
+        for (int e = 0; e < 2; ++e) {
+            engines[e]->move(move.first, move.second);
+        }
+    }
+
+    if (board.isDrawGame()) return -1;
+    return board.getWinner() == "X" ? xEngine : 1 - xEngine;
+}
+
+static double percentile(std::vector<double>& values, double fraction) {
+    if (values.empty()) return 0;
+    size_t rank = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    WorkStealingPool pool(options.threads);
+    std::vector<std::unique_ptr<TicTacToe>> engines;
+    try {
+        for (int i = 0; i < 2 * pool.size(); ++i) {
+            engines.push_back(std::make_unique<TicTacToe>(options.width, options.height, options.matchLength));
+            engines.back()->setHashSize(options.hashSizeMB);
+            engines.back()->setVerbose(false);
+        }
+    }
+    catch (const std::invalid_argument& error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+
+    GameRecordWriter records;
+    std::string recordError;
+    if (!options.record.empty() && !records.open(options.record, &recordError)) {
+        std::cerr << recordError << '\n';
+        return 1;
+    }
+
+    Totals totals;
+    std::mutex totalsMutex;
+    auto start = std::chrono::steady_clock::now();
+    for (int game = 0; game < options.games; ++game) {
+        pool.submit([&, game](int worker) {
+            TicTacToe* pair[2] = { engines[2 * worker].get(), engines[2 * worker + 1].get() };
+            Totals local;
+            int winner = playGame(game, options, pair, local);
+
+            std::lock_guard<std::mutex> lock(totalsMutex);
+            std::string error;
+            if (records.isOpen() && !pair[0]->writeRecord(records, &error)) std::cerr << error << '\n';
+            totals.latenciesMs.insert(totals.latenciesMs.end(), local.latenciesMs.begin(), local.latenciesMs.end());
+            totals.nodes += local.nodes;
+            totals.ttProbes += local.ttProbes;
+            totals.ttHits += local.ttHits;
+            totals.betaCutoffs += local.betaCutoffs;
+            totals.firstMoveCutoffs += local.firstMoveCutoffs;
+            totals.searchSeconds += local.searchSeconds;
+            if (winner < 0) totals.draws++;
+            else totals.wins[winner]++;
+        });
+    }
+    pool.wait();
+    if (records.isOpen() && !records.flush(&recordError)) {
+        std::cerr << recordError << '\n';
+        return 1;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int games = std::max(1, options.games);
+    std::ofstream file;
+    if (!options.output.empty()) file.open(options.output, std::ios::trunc);
+    std::ostream& report = options.output.empty() ? std::cout : file;
+    report << "{\n"
+        << "  \"board\": \"" << options.width << "x" << options.height << "\",\n"
+        << "  \"matchLength\": " << options.matchLength << ",\n"
+        << "  \"games\": " << options.games << ",\n"
+        << "  \"threads\": " << pool.size() << ",\n"
+        << "  \"engineA\": " << options.engines[0].json() << ",\n"
+        << "  \"engineB\": " << options.engines[1].json() << ",\n"
+        << "  \"elapsedSeconds\": " << elapsed << ",\n"
+        << "  \"gamesPerSecond\": " << options.games / elapsed << ",\n"
+        << "  \"searchedMoves\": " << totals.latenciesMs.size() << ",\n"
+        << "  \"nodes\": " << totals.nodes << ",\n"
+        << "  \"nodesPerSecond\": " << (totals.searchSeconds > 0 ? totals.nodes / totals.searchSeconds : 0) << ",\n"
+        << "  \"ttHitRate\": " << (totals.ttProbes ? static_cast<double>(totals.ttHits) / totals.ttProbes : 0) << ",\n"
+        << "  \"firstMoveCutoffRatio\": " << (totals.betaCutoffs ? static_cast<double>(totals.firstMoveCutoffs) / totals.betaCutoffs : 0) << ",\n"
+        << "  \"latencyMs\": {\"p50\": " << percentile(totals.latenciesMs, 0.50)
+        << ", \"p99\": " << percentile(totals.latenciesMs, 0.99)
+        << ", \"max\": " << percentile(totals.latenciesMs, 1.0) << "},\n"
+        << "  \"winsA\": " << totals.wins[0] << ",\n"
+        << "  \"winsB\": " << totals.wins[1] << ",\n"
+        << "  \"draws\": " << totals.draws << ",\n"
+        << "  \"winRateA\": " << static_cast<double>(totals.wins[0]) / games << ",\n"
+        << "  \"winRateB\": " << static_cast<double>(totals.wins[1]) / games << "\n"
+        << "}\n";
+    if (!report) {
+        std::cerr << "Could not write " << options.output << '\n';
+        return 1;
+    }
+    return 0;
+}